@@ -0,0 +1,91 @@
+// Check that a baked sdf_grid never overstates the distance to the
+// surface from outside of it, so that marching cannot step through thin
+// features, with
+// a sphere and a plate thinner than a cell, which every ray must hit.
+
+#include "sdf_grid.h"
+#include <iostream>
+#include <cmath>
+#include <random>
+
+using namespace giulia;
+
+
+int main() {
+
+	const unsigned int resolution = 64;
+	const real spacing = 2.6 / resolution;
+	const real thickness = 0.3 * spacing;
+
+	const distance_SDF sphere = [](vec3 p) {
+		return p.length() - 0.7;
+	};
+
+	// A plate at z = 0.1, thinner than a cell
+	const distance_SDF plate = [thickness](vec3 p) {
+		const real dx = std::abs((double) p[0]) - 0.8;
+		const real dy = std::abs((double) p[1]) - 0.8;
+		const real dz = std::abs((double) (p[2] - 0.1)) - thickness / 2;
+		const real ox = dx > 0 ? dx : 0;
+		const real oy = dy > 0 ? dy : 0;
+		const real oz = dz > 0 ? dz : 0;
+		const real inside = std::max(dx, std::max(dy, dz));
+		return std::sqrt((double) (ox * ox + oy * oy + oz * oz)) + (inside < 0 ? inside : 0);
+	};
+
+	const distance_SDF functions[] = {sphere, plate};
+	const char* names[] = {"sphere", "plate"};
+
+	std::mt19937 rng(5);
+	std::uniform_real_distribution<double> u(-2, 2);
+	unsigned int failed = 0;
+
+	for (unsigned int f = 0; f < 2; ++f) {
+
+		sdf_grid grid = sdf_grid(vec3(-1.3), vec3(1.3), resolution, 8);
+		grid.bake(functions[f]);
+
+		// The bound alone, without refinement near the surface
+		sdf_grid coarse = grid;
+		coarse.set_exact(nullptr);
+
+		unsigned int over = 0;
+
+		for (unsigned int k = 0; k < 200000; ++k) {
+
+			const vec3 p = {u(rng), u(rng), u(rng)};
+			const real d = functions[f](p);
+
+			if(d > 0 && (coarse.distance(p) > d + 1E-6 || grid.distance(p) > d + 1E-6))
+				over++;
+		}
+
+		// Rays through the plate from above, at random offsets within cells,
+		// marching the bound alone so that refinement cannot save them
+		unsigned int missed = 0;
+
+		for (unsigned int k = 0; f == 1 && k < 2000; ++k) {
+
+			const vec3 camera = {u(rng) * 0.3, u(rng) * 0.3, 1.5};
+			const vec3 direction = vec3({u(rng) * 0.05, u(rng) * 0.05, -1}).normalized();
+
+			const pixel p = coarse.raymarch(
+				[](vec3 p) { return de_object(0, pixel(255, 255, 255)); },
+				camera, direction, pixel(0, 0, 0), 0.0001, 200);
+
+			if(p.r == 0)
+				missed++;
+		}
+
+		const bool ok = !over && !missed;
+
+		std::cout << "sdf_grid " << names[f] << ": " << over
+			<< " of 200000 lookups overstate the distance, " << missed
+			<< " rays missed" << (ok ? "" : " (FAILED)") << std::endl;
+
+		if(!ok)
+			failed++;
+	}
+
+	return failed ? 1 : 0;
+}
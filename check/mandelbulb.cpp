@@ -0,0 +1,83 @@
+// Check the trig-free Mandelbulb kernel against the polar form of the
+// power of the point, evaluated with the trigonometric functions of the
+// standard library, as theoretica's acos is only accurate to about 1e-5
+
+#include "raymarching.h"
+#include <cmath>
+#include <random>
+#include <iostream>
+
+using namespace giulia;
+
+
+// Distance to the Mandelbulb by the polar form, as by sdf::mandelbulb_distance()
+double mandelbulb_reference(vec3 pos, unsigned int power, unsigned int iterations) {
+
+	const double cx = pos[0], cy = pos[1], cz = pos[2];
+	double x = cx, y = cy, z = cz;
+	double dr = 1;
+	double r = 0;
+
+	for (unsigned int i = 0; i < iterations; i++) {
+
+		r = std::sqrt(x * x + y * y + z * z);
+
+		if (r > 2)
+			break;
+
+		const double theta = std::acos(z / r) * power;
+		const double phi = std::atan2(y, x) * power;
+
+		const double r_pow_1 = std::pow(r, (int) power - 1);
+		dr = r_pow_1 * power * dr + 1;
+
+		const double zr = r_pow_1 * r;
+
+		x = zr * std::sin(theta) * std::cos(phi) + cx;
+		y = zr * std::sin(theta) * std::sin(phi) + cy;
+		z = zr * std::cos(theta) + cz;
+	}
+
+	return 0.5 * std::log(r) * r / dr;
+}
+
+
+int main() {
+
+	const unsigned int points = 100000;
+	const double tolerance = 1e-6;
+
+	std::mt19937 rng(1);
+	std::uniform_real_distribution<double> u(-1.3, 1.3);
+
+	const unsigned int powers[] = {2, 3, 8, 9};
+	const unsigned int iterations[] = {2, 5, 10};
+	int result = 0;
+
+	for (unsigned int power : powers) {
+		for (unsigned int n : iterations) {
+
+			double max_error = 0;
+
+			for (unsigned int k = 0; k < points; ++k) {
+
+				const vec3 p = {u(rng), u(rng), u(rng)};
+				const double expected = mandelbulb_reference(p, power, n);
+				const double value = sdf::mandelbulb_polynomial(p, power, n);
+				const double error = std::abs(value - expected) / (std::abs(expected) + 1e-6);
+
+				if(!(error <= max_error))
+					max_error = error;
+			}
+
+			const bool pass = max_error <= tolerance;
+			result |= !pass;
+
+			std::cout << "mandelbulb_polynomial: power " << power << ", " << n
+				<< " iterations, max relative error " << max_error
+				<< (pass ? "" : " FAILED") << std::endl;
+		}
+	}
+
+	return result;
+}
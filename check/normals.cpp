@@ -0,0 +1,144 @@
+// Benchmark the estimators of surface normals at the hit points of a view
+// of blended spheres and of the Mandelbulb, against the exact normal over
+// multidual numbers, and check the order of their error on a surface
+// whose curvature biases the tetrahedral taps.
+
+#include "sdf_scene.h"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <vector>
+#include <cmath>
+
+using namespace giulia;
+using clock_type = std::chrono::steady_clock;
+
+
+// Angle between two unit vectors, in degrees
+real angle(vec3 a, vec3 b) {
+	return std::acos((double) theoretica::clamp(a * b, -1, 1)) * 180 / M_PI;
+}
+
+
+// Time each estimator at the hit points of a view of <d>, returning
+// the mean error of the tetrahedral taps against the exact normal
+template<typename Distance, typename DualDistance>
+real bench(const char* name, const Distance& d, const DualDistance& dd, vec3 camera) {
+
+	const unsigned int size = 128;
+	const real epsilon = 0.0005;
+	std::vector<vec3> hits;
+
+	for (unsigned int j = 0; j < size; ++j) {
+		for (unsigned int i = 0; i < size; ++i) {
+
+			const vec3 direction = vec3({i / (real) size - 0.5, j / (real) size - 0.5, -1}).normalized();
+			real t = 0;
+
+			for (unsigned int s = 0; s < 200 && t < 20; ++s) {
+
+				const real r = d(camera + direction * t);
+
+				if(r < epsilon) {
+					hits.push_back(camera + direction * t);
+					break;
+				}
+
+				t += r;
+			}
+		}
+	}
+
+	std::vector<vec3> exact(hits.size());
+	std::vector<vec3> normals(hits.size());
+
+	auto start = clock_type::now();
+
+	for (size_t k = 0; k < hits.size(); ++k)
+		exact[k] = normal_exact(dd, hits[k]);
+
+	const double exact_ns = std::chrono::duration<double>(
+		clock_type::now() - start).count() * 1E+09 / hits.size();
+
+	std::cout << name << ", " << hits.size() << " hit points:" << std::endl;
+	std::cout << std::fixed << std::setprecision(0)
+		<< "  exact (multidual)  " << exact_ns << " ns" << std::endl;
+
+	const auto run = [&](const char* label, real h, bool tetrahedral) {
+
+		auto start = clock_type::now();
+
+		for (size_t k = 0; k < hits.size(); ++k)
+			normals[k] = tetrahedral
+				? normal_tetrahedral(d, hits[k], h)
+				: normal_central(d, hits[k], h);
+
+		const double ns = std::chrono::duration<double>(
+			clock_type::now() - start).count() * 1E+09 / hits.size();
+
+		real error = 0;
+		for (size_t k = 0; k < hits.size(); ++k)
+			error += angle(normals[k], exact[k]);
+
+		error /= hits.size();
+
+		std::cout << std::setprecision(0) << "  " << label << ns << " ns, "
+			<< std::scientific << std::setprecision(2) << error
+			<< " deg mean error" << std::fixed << std::endl;
+
+		return error;
+	};
+
+	run("central, h = 1     ", 1, false);
+	run("central, h = eps   ", epsilon, false);
+
+	return run("tetrahedral, eps   ", epsilon, true);
+}
+
+
+int main() {
+
+	const auto scene = sdf::make_blend(
+		sdf::make_blend(
+			sdf::make_sphere({-1, 0, -6}, 1, pixel(0xFA0A0A)),
+			sdf::make_sphere({1, 1, -7}, 1.5, pixel(0x0AFA0A)), 0.7),
+		sdf::make_sphere({-1, -1.5, -5.8}, 0.75, pixel(0x0A0AFA)), 0.5);
+
+	const real spheres = bench("blended spheres",
+		[&scene](vec3 p) { return scene.distance(p); },
+		[&scene](const dual_vec3& p) { return scene.distance(p); }, {0, 0, 0});
+
+	bench("Mandelbulb",
+		[](vec3 p) { return sdf::mandelbulb_distance(p); },
+		[](const dual_vec3& p) { return sdf::mandelbulb_distance(p); }, {0, 0, 3});
+
+	// The surface x + xy + y^3 = 0 has the normal (1, 0, 0) at the origin,
+	// where the xy term biases the tetrahedral taps by the first order in h
+	// and the y^3 term biases central differences by the second order
+	const auto surface = [](vec3 p) {
+		return p.get(0) + p.get(0) * p.get(1) + p.get(1) * p.get(1) * p.get(1);
+	};
+
+	const vec3 normal = {1, 0, 0};
+	const vec3 origin = {0, 0, 0};
+
+	const real tetrahedral_order = std::log2((double) (
+		angle(normal_tetrahedral(surface, origin, 0.01), normal)
+		/ angle(normal_tetrahedral(surface, origin, 0.005), normal)));
+
+	const real central_order = std::log2((double) (
+		angle(normal_central(surface, origin, 0.01), normal)
+		/ angle(normal_central(surface, origin, 0.005), normal)));
+
+	std::cout << std::setprecision(2) << "order of the error: tetrahedral "
+		<< tetrahedral_order << ", central " << central_order << std::endl;
+
+	const bool ok = spheres < 0.1
+		&& std::abs((double) tetrahedral_order - 1) < 0.1
+		&& std::abs((double) central_order - 2) < 0.1;
+
+	if(!ok)
+		std::cout << "normals: FAILED" << std::endl;
+
+	return ok ? 0 : 1;
+}
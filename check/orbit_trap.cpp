@@ -0,0 +1,60 @@
+// Check that an orbit trap engine with more traps than fit in registers
+// tracks every one of them, giving the same distances, iterations and
+// last iterate as engines of a single trap each.
+
+#include "orbit_trap.h"
+#include <iostream>
+#include <random>
+
+using namespace giulia;
+
+
+int main() {
+
+	std::mt19937 rng(3);
+	std::uniform_real_distribution<double> u(-1.5, 1.5);
+
+	// Enough traps of every shape to need several blocks of packs
+	std::vector<orbit_trap> traps;
+
+	for (unsigned int k = 0; k < 40; ++k) {
+		switch(k % 4) {
+			case 0: traps.push_back(orbit_trap::point(u(rng), u(rng))); break;
+			case 1: traps.push_back(orbit_trap::line(u(rng), u(rng), u(rng))); break;
+			case 2: traps.push_back(orbit_trap::circle(u(rng), u(rng), u(rng) + 1.5)); break;
+			case 3: traps.push_back(orbit_trap::cross(u(rng), u(rng), u(rng))); break;
+		}
+	}
+
+	const orbit_trap_engine engine = orbit_trap_engine(traps);
+	unsigned int wrong = 0;
+
+	for (unsigned int n = 0; n < 1000; ++n) {
+
+		const real_t c_a = u(rng);
+		const real_t c_b = u(rng);
+
+		real_t z_a = 0, z_b = 0;
+		std::vector<real_t> dist(traps.size());
+		const unsigned int iter = engine.iterate(z_a, z_b, c_a, c_b, dist.data(), 200);
+
+		for (unsigned int k = 0; k < traps.size(); ++k) {
+
+			const orbit_trap_engine single = orbit_trap_engine({traps[k]});
+
+			real_t s_a = 0, s_b = 0, d;
+			const unsigned int s_iter = single.iterate(s_a, s_b, c_a, c_b, &d, 200);
+
+			if(d != dist[k] || s_iter != iter || s_a != z_a || s_b != z_b)
+				wrong++;
+		}
+	}
+
+	const bool ok = engine.size() == traps.size() && !wrong;
+
+	std::cout << "orbit_trap_engine: " << engine.size() << " of " << traps.size()
+		<< " traps tracked, " << wrong << " distances differ"
+		<< (ok ? "" : " (FAILED)") << std::endl;
+
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,67 @@
+// Check that rays recovered by the grazing fallback of raymarch_relaxed()
+// are shaded with the color of the object they graze, darkened by the
+// occlusion of the step their candidate was found at. Rays whose closest
+// approach falls within the last few steps are as dark as any hit after
+// that many steps, but a ray shaded as out of steps would always be black.
+
+#include "sdf_scene.h"
+#include <iostream>
+
+using namespace giulia;
+
+
+int main() {
+
+	const pixel color = pixel(255, 255, 255);
+	const pixel background = pixel(0, 0, 255);
+
+	const auto sphere = sdf::make_sphere({0, 0, 0}, 1, color);
+	const auto d = [&sphere](vec3 p) { return sphere.distance(p); };
+
+	const vec3 camera = {0, 0, 3};
+	const unsigned int rays = 2000;
+	const unsigned int max_steps = 40;
+
+	unsigned int recovered = 0;
+	unsigned int black = 0;
+	unsigned int failed = 0;
+
+	// Sweep rays across the silhouette of the sphere
+	for (unsigned int k = 0; k < rays; ++k) {
+
+		const real x = 0.3 + 0.1 * k / (real) rays;
+		const vec3 direction = vec3({x, 0, -1}).normalized();
+
+		// Without the fallback, as candidates never hit
+		// within a single footprint
+		const pixel strict = raymarch_relaxed(
+			d, sphere, camera, direction, background,
+			1.6, 0.001, 10, max_steps, 1);
+
+		const pixel p = raymarch_relaxed(
+			d, sphere, camera, direction, background,
+			1.6, 0.001, 10, max_steps, 4);
+
+		const bool strict_miss = strict.r == background.r
+			&& strict.g == background.g && strict.b == background.b;
+		const bool miss = p.r == background.r
+			&& p.g == background.g && p.b == background.b;
+
+		if(!strict_miss || miss)
+			continue;
+
+		recovered++;
+
+		// The object is white, so recovered rays are gray
+		if(p.r != p.g || p.g != p.b)
+			failed++;
+		else if(p.r == 0)
+			black++;
+	}
+
+	std::cout << "raymarch_relaxed: " << recovered << " grazing rays recovered, "
+		<< failed << " not shaded with the object color, "
+		<< black << " black" << std::endl;
+
+	return (recovered && !failed && black * 10 < recovered) ? 0 : 1;
+}
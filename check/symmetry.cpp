@@ -0,0 +1,105 @@
+// Check that rendering a symmetric scene gives the same image as drawing
+// every pixel at symmetric_coords(), while drawing only a fraction of
+// them, for each symmetry, image sizes of both parities and centers
+// which do not lie on the pixel grid.
+
+#include "render.h"
+#include <iostream>
+#include <cmath>
+#include <atomic>
+
+using namespace giulia;
+
+
+// A scene with the symmetry of <mode> about (x0, y0), colored by bands
+pixel scene(real_t x, real_t y, int mode, real_t x0, real_t y0) {
+
+	real_t dx = x - x0;
+	real_t dy = y - y0;
+
+	switch(mode) {
+		case SYMMETRY_MIRROR_X: dy = std::abs(dy); break;
+		case SYMMETRY_MIRROR_Y: dx = std::abs(dx); break;
+		case SYMMETRY_POINT:
+			if(dx < 0 || (dx == 0 && dy < 0)) {
+				dx = -dx;
+				dy = -dy;
+			}
+			break;
+		case SYMMETRY_ROTATION: {
+			const real_t r2 = dx * dx + dy * dy;
+			dy = dx * dx * dy * dy * 40;
+			dx = r2;
+			break;
+		}
+	}
+
+	const int a = std::floor((double) (std::sin((double) (7.3 * dx + 3.1 * dy * dy)) * 40));
+	const int b = std::floor((double) (dx * 53.7 + dy * 29.3));
+
+	return pixel(a & 255, b & 255, (a ^ b) & 255);
+}
+
+
+int main() {
+
+	const unsigned int sizes[][2] = {{256, 256}, {255, 255}, {256, 191}};
+	const int modes[] = {SYMMETRY_MIRROR_X, SYMMETRY_MIRROR_Y, SYMMETRY_POINT, SYMMETRY_ROTATION};
+	const char* names[] = {"mirror-x", "mirror-y", "point", "rotation"};
+	const real_t centers[][2] = {{0, 0}, {0.1234, -0.0567}};
+
+	unsigned int failed = 0;
+
+	for (auto c : centers) {
+		for (auto sz : sizes) {
+			for (unsigned int m = 0; m < 4; ++m) {
+
+				const unsigned int w = sz[0];
+				const unsigned int h = sz[1];
+				const int mode = modes[m];
+
+				global_state state;
+				state["symmetry"] = mode;
+				state["symmetry.x"] = c[0];
+				state["symmetry.y"] = c[1];
+				state["symmetry.order"] = 4;
+
+				std::atomic<unsigned int> drawn(0);
+				image img = image(w, h);
+
+				render(img, state, [&](real_t x, real_t y, global_state& state) {
+					drawn++;
+					return scene(x, y, mode, c[0], c[1]);
+				});
+
+				unsigned int wrong = 0;
+
+				for (unsigned int i = 0; i < w * h; ++i) {
+
+					real_t x, y;
+					symmetric_coords(i, w, h, state, x, y);
+					const pixel p = scene(x, y, mode, c[0], c[1]);
+
+					if(p.r != img[i].r || p.g != img[i].g || p.b != img[i].b)
+						wrong++;
+				}
+
+				// About the center of the image, every symmetry halves the pixels
+				// to draw at least, while off center the pixels whose images
+				// fall outside of the image are drawn too
+				const bool centered = c[0] == 0 && c[1] == 0;
+				const bool ok = !wrong && drawn <= w * h * (centered ? 0.55 : 0.7);
+
+				std::cout << "symmetry " << names[m] << " about ("
+					<< c[0] << ", " << c[1] << "), " << w << "x" << h << ": "
+					<< drawn << " of " << (w * h) << " pixels drawn, "
+					<< wrong << " differ" << (ok ? "" : " (FAILED)") << std::endl;
+
+				if(!ok)
+					failed++;
+			}
+		}
+	}
+
+	return failed ? 1 : 0;
+}
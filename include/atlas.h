@@ -0,0 +1,67 @@
+#pragma once
+
+// Atlases of Julia sets over a grid of parameters
+
+#include "common.h"
+#include "image.h"
+#include <vector>
+
+
+namespace giulia {
+
+
+	// A contact sheet of K x K Julia sets, with parameters c sampled at the
+	// centers of a grid over a region of the Mandelbrot plane. All thumbnails
+	// are drawn by a single parallel loop over the pixels of the atlas, each
+	// with its own iteration budget chosen by a quick probe.
+	struct julia_atlas {
+
+		public:
+
+			// Construct an atlas of <k> x <k> thumbnails of <thumb> x <thumb> pixels,
+			// with parameters over [c_x_min, c_x_max] x [c_y_min, c_y_max] and
+			// each thumbnail showing [-radius, radius] x [-radius, radius]
+			julia_atlas(
+				unsigned int k, unsigned int thumb,
+				real_t c_x_min = -2, real_t c_y_min = -1.5,
+				real_t c_x_max = 1, real_t c_y_max = 1.5,
+				real_t radius = 1.6);
+
+
+			// Choose the iteration budget of every thumbnail between <min_iter> and
+			// <max_iter>, doubling it while a sparse probe of the thumbnail shows
+			// orbits escaping in the second half of the budget, then draw all the
+			// thumbnails into <img>, which must be get_size() pixels wide and high
+			void render(image& img, unsigned int min_iter = 64, unsigned int max_iter = 4096);
+
+
+			// Draw the Mandelbrot set over the parameter region into <img>,
+			// with the cell of every thumbnail outlined, as an index of the atlas
+			void draw_index(image& img) const;
+
+
+			// Get the parameter of the thumbnail in column <i> and row <j>
+			void get_parameter(unsigned int i, unsigned int j, real_t& c_x, real_t& c_y) const;
+
+
+			// Get the iteration budget of the thumbnail in column <i> and row <j>
+			unsigned int get_budget(unsigned int i, unsigned int j) const;
+
+
+			// Get the width and height of the atlas in pixels
+			unsigned int get_size() const;
+
+
+		private:
+
+			unsigned int k;
+			unsigned int thumb;
+			real_t c_x_min, c_y_min;
+			real_t c_x_max, c_y_max;
+			real_t radius;
+
+			// Iteration budget of each thumbnail, by rows
+			std::vector<unsigned int> budgets;
+	};
+
+}
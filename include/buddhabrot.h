@@ -0,0 +1,88 @@
+#pragma once
+
+// Buddhabrot and Nebulabrot density rendering
+
+#include "common.h"
+#include "image.h"
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+
+namespace giulia {
+
+
+	// A band of escape times accumulated into its own channel
+	struct buddhabrot_channel {
+
+		// Minimum and maximum escape time of the orbits in the band
+		unsigned int min_iter;
+		unsigned int max_iter;
+
+		// Color of the channel in the output image
+		pixel color;
+	};
+
+
+	// Density histogram of the escaping orbits of z_i+1 = z_i^2 + c.
+	// Orbits are traced in parallel and accumulated into atomic 32-bit bins,
+	// which are periodically reduced into 64-bit totals before they can overflow.
+	struct buddhabrot {
+
+		public:
+
+			// Construct a histogram of <width> x <height> bins, viewing the
+			// region centered at (center_x, center_y) spanning <scale> horizontally
+			buddhabrot(
+				unsigned int width, unsigned int height,
+				real_t center_x = -0.5, real_t center_y = 0, real_t scale = 3);
+
+
+			// Add an escape time band as a separate channel.
+			// A single band gives a Buddhabrot, three bands with
+			// red, green and blue colors give a Nebulabrot.
+			void add_channel(unsigned int min_iter, unsigned int max_iter, pixel color);
+
+
+			// Sample <samples> parameters c and accumulate their escaping orbits,
+			// using Metropolis-Hastings sampling to favour the parameters whose
+			// orbits cross the view, or uniform sampling over |c| < 2 otherwise
+			void render(unsigned long long samples, bool metropolis = true, uint64_t seed = 1);
+
+
+			// Get the accumulated counts of the given channel
+			std::vector<uint64_t> get_histogram(unsigned int channel);
+
+
+			// Tone map the histogram onto an image of the same size,
+			// with gamma correction of the normalized densities
+			void draw(image& img, real_t gamma = 0.5);
+
+
+			// Get the number of channels
+			unsigned int get_channels() const;
+
+		private:
+
+			unsigned int width;
+			unsigned int height;
+			real_t center_x;
+			real_t center_y;
+			real_t scale;
+
+			std::vector<buddhabrot_channel> channels;
+
+			// Bins updated by the rendering threads, channel major
+			std::vector<std::atomic<uint32_t>> bins;
+
+			// Totals reduced from the bins
+			std::vector<uint64_t> totals;
+
+			// Move the bins into the totals and clear them
+			void reduce();
+
+			// Longest escape time of all channels
+			unsigned int max_escape() const;
+	};
+
+}
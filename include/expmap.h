@@ -0,0 +1,89 @@
+#pragma once
+
+// Exponential maps of zoom paths, for rendering zoom videos
+
+#include "common.h"
+#include "image.h"
+#include <string>
+#include <vector>
+#include <functional>
+
+
+namespace giulia {
+
+
+	// A coloring function of points of the complex plane
+	using plane_function = std::function<pixel(real_t, real_t)>;
+
+
+	// The log-polar strip of a zoom towards a center, where columns span
+	// the angle and rows span the logarithm of the radius with the same step,
+	// so that every frame of the zoom is a resampling of part of the strip.
+	// The strip is prefiltered into a mip chain, since the center of a frame
+	// covers many rows of the strip in a single pixel.
+	struct exp_map {
+
+		public:
+
+			// Construct the exponential map of a zoom towards (center_x, center_y)
+			// from radius <r_max> down to radius <r_min>, with <width> angular samples
+			exp_map(
+				real_t center_x, real_t center_y,
+				real_t r_max, real_t r_min, unsigned int width = 4096);
+
+
+			// Render the strip in parallel, coloring points of the plane with <f>
+			void render(plane_function f);
+
+
+			// Reconstruct the frame of half-width <radius> by resampling the strip,
+			// drawing the pixels within <patch> times the radius from the center
+			// and those outside of the strip directly with <f>
+			void draw(image& img, real_t radius, plane_function f, real_t patch = 0.0625) const;
+
+
+			// Render <frames> frames of the zoom at constant zoom speed,
+			// saving them as <prefix>_00000.bmp and so on, returning 0 on success
+			int render_frames(
+				unsigned int w, unsigned int h, unsigned int frames,
+				const std::string& prefix, plane_function f, real_t patch = 0.0625) const;
+
+
+			// Copy the strip to an image, with the outermost radius on top
+			void draw_strip(image& img) const;
+
+
+			// Get width of the strip
+			unsigned int get_width() const;
+
+
+			// Get height of the strip
+			unsigned int get_height() const;
+
+
+		private:
+
+			real_t center_x;
+			real_t center_y;
+			real_t r_max;
+			real_t r_min;
+
+			unsigned int width;
+			unsigned int height;
+
+			// Step of the angle and the logarithm of the radius between samples
+			real_t step;
+
+			// Mip chain of the strip, as interleaved float RGB
+			std::vector<std::vector<float>> levels;
+			std::vector<unsigned int> level_width;
+			std::vector<unsigned int> level_height;
+
+			// Build the mip chain from the first level
+			void build_levels();
+
+			// Bilinearly sample level <l> at strip coordinates (u, v)
+			void sample(unsigned int l, real_t u, real_t v, float* rgb) const;
+	};
+
+}
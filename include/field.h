@@ -0,0 +1,144 @@
+#pragma once
+
+// Iteration fields of escape-time fractals, decoupling computation from coloring
+
+#include "common.h"
+#include "image.h"
+#include <string>
+#include <vector>
+#include <functional>
+
+
+namespace giulia {
+
+
+	// Maximum number of orbit trap distances stored by a field
+	const unsigned int field_max_traps = 4;
+
+
+	// The coloring-independent result of an escape-time kernel at a point
+	struct field_sample {
+
+		// Smooth iteration count
+		real_t iter {0};
+
+		// Modulus of the last iterate
+		real_t modulus {0};
+
+		// Minimum distances of the orbit to its traps
+		real_t trap[field_max_traps] {0, 0, 0, 0};
+
+		// Exterior distance estimate to the boundary of the set,
+		// zero inside the set or for kernels which do not estimate it
+		real_t distance {0};
+	};
+
+
+	// A field sampling function, taking normalized coordinates like draw functions
+	using sample_function = std::function<field_sample(real_t, real_t, global_state&)>;
+
+
+	// A field coloring function, taking a sample and its normalized coordinates
+	using shade_function = std::function<pixel(const field_sample&, real_t, real_t)>;
+
+
+	// A float buffer of field samples, stored as separate planes
+	struct iteration_field {
+
+		public:
+
+			// Construct a field of width <w> and height <h>, with <traps> trap
+			// distances per sample, computed with at most <max_iter> iterations
+			iteration_field(unsigned int w = 0, unsigned int h = 0,
+				unsigned int traps = 0, unsigned int max_iter = 1000);
+
+
+			// Get the sample at index <i>
+			field_sample get_sample(unsigned int i) const;
+
+
+			// Set the sample at index <i>
+			void set_sample(unsigned int i, const field_sample& s);
+
+
+			// Get width of the field
+			unsigned int get_width() const;
+
+
+			// Get height of the field
+			unsigned int get_height() const;
+
+
+			// Get total sample size of the field
+			unsigned int get_size() const;
+
+
+			// Get the number of trap distances per sample
+			unsigned int get_traps() const;
+
+
+			// Get the iteration limit the field was computed with
+			unsigned int get_max_iter() const;
+
+
+			// Set the iteration limit the field was computed with
+			void set_max_iter(unsigned int max_iter);
+
+
+			// Get raw pointer to the smooth iteration plane
+			const float* get_iter() const;
+
+
+			// Save the field to a compact binary file, returning 0 on success
+			int save(const std::string& filename) const;
+
+
+			// Load a field from a file written by save(), returning 0 on success
+			int load(const std::string& filename);
+
+
+		private:
+			unsigned int width {0};
+			unsigned int height {0};
+			unsigned int traps {0};
+			unsigned int max_iter {1000};
+
+			// Sample planes
+			std::vector<float> iter;
+			std::vector<float> modulus;
+			std::vector<float> trap;
+			std::vector<float> distance;
+	};
+
+
+	// Sample every pixel of a field in parallel, using the same
+	// normalized coordinates as the rendering of images
+	void compute_field(iteration_field& f, global_state& state, sample_function sample);
+
+
+	// Choose an iteration limit for the current view and store it in
+	// state["max_iter"], which <sample> must read its limit from. The initial
+	// estimate grows with the zoom depth given by state["scale.x"] and is
+	// doubled, up to <limit>, while a low-resolution probe of <probe> columns
+	// shows more than <threshold> of the orbits escaping in the second half
+	// of the budget. Returns the chosen limit.
+	unsigned int auto_max_iter(
+		global_state& state, sample_function sample,
+		unsigned int probe = 64, real_t threshold = 0.002, unsigned int limit = 1000000);
+
+
+	// Sample a field in tiles of <tile> x <tile> pixels, starting from the limit
+	// in state["max_iter"] and doubling it, up to <limit>, for the tiles where
+	// some pixels hit it while more than <threshold> of them escape in the
+	// second half of the budget. Samples which never escaped are set to the
+	// highest limit used, which the field records and state["max_iter.peak"]
+	// reports, with the number of raised tiles in state["max_iter.raised"].
+	void compute_field_adaptive(
+		iteration_field& f, global_state& state, sample_function sample,
+		unsigned int tile = 32, real_t threshold = 0.01, unsigned int limit = 1000000);
+
+
+	// Color a field into an image of the same size
+	void shade_field(const iteration_field& f, image& img, shade_function shade);
+
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+// Iterated function systems and fractal flames
+
+#include "common.h"
+#include "image.h"
+#include <cstdint>
+#include <vector>
+
+
+namespace giulia {
+
+
+	// Nonlinear variation applied after the affine map of a transform
+	enum flame_variation {
+		VAR_LINEAR,
+		VAR_SINUSOIDAL,
+		VAR_SPHERICAL,
+		VAR_SWIRL,
+		VAR_HORSESHOE,
+		VAR_POLAR
+	};
+
+
+	// A transform of an iterated function system, mapping (x, y) to
+	// V(a x + b y + c, d x + e y + f) for a variation V
+	struct flame_transform {
+
+		// Affine coefficients
+		real_t a {1}, b {0}, c {0};
+		real_t d {0}, e {1}, f {0};
+
+		// Probability weight of choosing the transform
+		real_t weight {1};
+
+		// Nonlinear variation
+		flame_variation variation {VAR_LINEAR};
+
+		// Color blended into the points mapped by the transform
+		pixel color {pixel(255, 255, 255)};
+
+		flame_transform() {}
+
+		flame_transform(
+			real_t a, real_t b, real_t c, real_t d, real_t e, real_t f,
+			real_t weight = 1, flame_variation variation = VAR_LINEAR,
+			pixel color = pixel(255, 255, 255))
+			: a(a), b(b), c(c), d(d), e(e), f(f),
+			weight(weight), variation(variation), color(color) {}
+	};
+
+
+	// Density renderer of iterated function systems using the chaos game.
+	// Every thread runs its own random stream and accumulates into its own
+	// float density buffer. Float bins only count exactly up to 2^24 points,
+	// so the buffers are merged into double totals every 2^24 points.
+	struct flame {
+
+		public:
+
+			// Construct a renderer of <width> x <height> bins over the
+			// region [x_min, x_max] x [y_min, y_max] of the plane
+			flame(
+				unsigned int width, unsigned int height,
+				real_t x_min = -1, real_t y_min = -1,
+				real_t x_max = 1, real_t y_max = 1);
+
+
+			// Add a transform to the system
+			void add_transform(const flame_transform& t);
+
+
+			// Run the chaos game for <samples> points in total
+			void render(unsigned long long samples, uint64_t seed = 1);
+
+
+			// Get the number of points which fell in the bin (i, j),
+			// counting rows from the top
+			real_t density(unsigned int i, unsigned int j) const;
+
+
+			// Tone map the log-density onto an image of the same size,
+			// leaving the pixels no point fell on untouched
+			void draw(image& img, real_t gamma = 2.2, real_t brightness = 1);
+
+		private:
+
+			unsigned int width;
+			unsigned int height;
+			real_t x_min, y_min;
+			real_t x_max, y_max;
+
+			std::vector<flame_transform> transforms;
+
+			// Merged counts and accumulated colors of each bin
+			std::vector<double> counts;
+			std::vector<double> colors;
+	};
+
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+// Complex formulas compiled to register bytecode
+
+#include "common.h"
+#include "image.h"
+#include <array>
+#include <string>
+#include <vector>
+
+
+namespace giulia {
+
+
+	// A single bytecode instruction, computing reg[dst] = op(reg[a], reg[b])
+	struct formula_instruction {
+
+		// Operation code
+		unsigned char op;
+
+		// Destination register
+		unsigned short dst;
+
+		// Operand registers
+		unsigned short a;
+		unsigned short b;
+
+		// Integer immediate (exponent of integer powers)
+		int n;
+	};
+
+
+	// A complex formula in the variables z and c, such as "z^3 - sin(z)^2 + c",
+	// compiled to register bytecode with constant folding and
+	// common subexpression elimination.
+	//
+	// Supported syntax:
+	// - Variables z and c, the imaginary unit i and real numbers
+	// - Operators + - * / ^ and parentheses
+	// - Functions sin, cos, tan, exp, ln, sqrt, conj
+	struct formula {
+
+		public:
+
+			// Number of lanes evaluated at once by the batch interpreter
+			static constexpr unsigned int batch_size = 64;
+
+
+			formula() {}
+
+			// Compile the given expression
+			// @see compile
+			formula(const std::string& expr);
+
+
+			// Compile the given expression, returning 0 on success
+			// and -1 on a syntax error, which is then available through get_error()
+			int compile(const std::string& expr);
+
+
+			// Whether the formula compiled successfully
+			bool valid() const;
+
+
+			// Get the last compilation error
+			std::string get_error() const;
+
+
+			// Get the number of bytecode instructions
+			unsigned int size() const;
+
+
+			// Get the number of registers used by the bytecode
+			unsigned int registers() const;
+
+
+			// Evaluate the formula at a single point
+			std::array<real_t, 2> operator()(
+				real_t z_a, real_t z_b, real_t c_a = 0, real_t c_b = 0) const;
+
+
+			// Evaluate the formula in place at a single point,
+			// using <regs> as scratch space of size 2 * registers()
+			void eval(real_t& z_a, real_t& z_b, real_t c_a, real_t c_b, real_t* regs) const;
+
+
+			// Evaluate the formula in place over <n> points, at most batch_size,
+			// using <regs> as scratch space of size 2 * registers() * batch_size
+			void eval(double* z_a, double* z_b, const double* c_a, const double* c_b,
+				unsigned int n, double* regs) const;
+
+
+			// Print the bytecode for inspection
+			std::string disassemble() const;
+
+		private:
+
+			std::vector<formula_instruction> code;
+
+			// Constant values, loaded into the registers following z and c
+			std::vector<std::array<real_t, 2>> constants;
+
+			unsigned int n_regs {0};
+			unsigned int result {0};
+			std::string error {"empty formula"};
+	};
+
+
+	// Draw the escape-time fractal of z_i+1 = f(z_i, c), with z_0 = c = (x, y)
+	pixel draw_formula(real_t x, real_t y, const formula& f, real_t R = 2, unsigned int max_iter = 1000);
+
+
+	// Draw <n> pixels of the escape-time fractal of a formula,
+	// interpreting the bytecode once per batch of pixels
+	void draw_formula(
+		const real_t* x, const real_t* y, pixel* out, unsigned int n,
+		const formula& f, real_t R = 2, unsigned int max_iter = 1000);
+
+}
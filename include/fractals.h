@@ -2,7 +2,10 @@
 
 #include "common.h"
 #include "image.h"
+#include "field.h"
 #include <array>
+#include <string>
+#include <vector>
 #include <functional>
 
 
@@ -17,22 +20,89 @@ namespace giulia {
 	pixel draw_giulia_present(real_t x, real_t y, unsigned int max_iter = 2500);
 
 
+	// Sample the very special Julia fractal, with its four orbit traps
+	field_sample sample_giulia_present(real_t x, real_t y, unsigned int max_iter = 2500);
+
+
+	// Color a sample of the very special Julia fractal
+	pixel shade_giulia_present(const field_sample& s, real_t x, real_t y, unsigned int max_iter = 2500);
+
+
 	// Draw a Julia fractal with parameter (c_x, c_y)
 	pixel draw_julia(real_t x, real_t y, real_t c_x = -0.76, real_t c_y = 0.1482, unsigned int max_iter = 1000);
 
 
+	// Sample a Julia fractal with parameter (c_x, c_y)
+	field_sample sample_julia(real_t x, real_t y, real_t c_x = -0.76, real_t c_y = 0.1482, unsigned int max_iter = 1000);
+
+
 	// Draw the Mandelbrot fractal
 	pixel draw_mandelbrot(real_t x, real_t y, unsigned int max_iter = 1000);
 
 
+	// Sample the Mandelbrot fractal
+	field_sample sample_mandelbrot(real_t x, real_t y, unsigned int max_iter = 1000);
+
+
 	// Draw the Mandelbar fractal
 	pixel draw_mandelbar(real_t x, real_t y, unsigned int max_iter = 1000);
 
 
+	// Sample the Mandelbar fractal
+	field_sample sample_mandelbar(real_t x, real_t y, unsigned int max_iter = 1000);
+
+
 	// Draw a fractal map
 	pixel draw_fractal(real_t x, real_t y, fractal_map f, real_t R = 2, unsigned int max_iter = 1000);
 
 
+	// Sample a fractal map
+	field_sample sample_fractal(real_t x, real_t y, fractal_map f, real_t R = 2, unsigned int max_iter = 1000);
+
+
+	// Gray scale coloring of a sample by its smooth iteration count
+	pixel shade_gray(const field_sample& s, unsigned int max_iter, real_t brightness);
+
+
+	// Gray scale coloring of a sample by its smooth iteration count, blending
+	// towards the color of the set within one pixel footprint <pixel_size>
+	// of the boundary, by the exterior distance estimate of the sample
+	pixel shade_distance(
+		const field_sample& s, real_t pixel_size,
+		unsigned int max_iter, real_t brightness);
+
+
+	// Bound the smooth iteration count of the Mandelbrot fractal over the region
+	// [x_min, x_max] x [y_min, y_max] by interval arithmetic. Returns true when
+	// every orbit of the region provably escapes at the same iteration,
+	// with smooth iteration counts in [iter_min, iter_max].
+	bool bound_mandelbrot(
+		real_t x_min, real_t y_min, real_t x_max, real_t y_max,
+		real_t& iter_min, real_t& iter_max, unsigned int max_iter = 1000);
+
+
+	// Bound the smooth iteration count of a Julia fractal with parameter
+	// (c_x, c_y) over a region, as bound_mandelbrot
+	bool bound_julia(
+		real_t x_min, real_t y_min, real_t x_max, real_t y_max,
+		real_t& iter_min, real_t& iter_max,
+		real_t c_x = -0.76, real_t c_y = 0.1482, unsigned int max_iter = 1000);
+
+
+	// Whether draw_mandelbrot provably draws a single color, set in <fill>,
+	// over the region [x_min, x_max] x [y_min, y_max]
+	bool cull_mandelbrot(
+		real_t x_min, real_t y_min, real_t x_max, real_t y_max,
+		pixel& fill, unsigned int max_iter = 1000);
+
+
+	// Whether draw_julia provably draws a single color, set in <fill>,
+	// over the region [x_min, x_max] x [y_min, y_max]
+	bool cull_julia(
+		real_t x_min, real_t y_min, real_t x_max, real_t y_max, pixel& fill,
+		real_t c_x = -0.76, real_t c_y = 0.1482, unsigned int max_iter = 1000);
+
+
 	// Draw a Sierpinski triangle (in post-processing)
 	void draw_sierpinski_triangle(
 		image& img, real_t x = 0, real_t y = 0,
@@ -40,7 +110,64 @@ namespace giulia {
 		pixel c = pixel(255, 255, 255));
 
 
+	// Draw a Sierpinski triangle (in post-processing) with the parallel
+	// flame renderer, shading its points by their log-density
+	void draw_sierpinski_flame(
+		image& img, real_t x = 0, real_t y = 0,
+		real_t width = 0, unsigned int iter = 1000000,
+		pixel c = pixel(255, 255, 255));
+
+
+	// Newton's fractal of a polynomial, prepared once from its roots and colors
+	struct newton_fractal {
+
+		public:
+
+			// Construct the fractal of the monic polynomial with the given <roots>,
+			// each one drawn with the corresponding color
+			newton_fractal(
+				const std::vector<std::array<real_t, 2>>& roots,
+				const std::vector<pixel>& colors,
+				unsigned int max_iter = 30,
+				real_t epsilon = 0.00000001);
+
+
+			// Draw the pixel at (x, y)
+			pixel operator()(real_t x, real_t y) const;
+
+
+			// Draw <n> pixels at once, processing them in SIMD lanes
+			void draw(const real_t* x, const real_t* y, pixel* out, unsigned int n) const;
+
+
+			// Get the degree of the polynomial
+			unsigned int degree() const;
+
+
+		private:
+
+			// Polynomial coefficients, from the highest degree to the constant term
+			std::vector<real_t> coeff_re;
+			std::vector<real_t> coeff_im;
+
+			// Polynomial roots
+			std::vector<real_t> roots_re;
+			std::vector<real_t> roots_im;
+
+			std::vector<pixel> colors;
+			unsigned int max_iter;
+			real_t epsilon;
+
+			// Color a converged point given the nearest root and the iteration count
+			pixel shade(unsigned int root, unsigned int iter) const;
+
+			// Index of the root nearest to (z_a, z_b)
+			unsigned int nearest_root(real_t z_a, real_t z_b) const;
+	};
+
+
 	// Draw Newton's fractal
+	// @see newton_fractal, which should be preferred when drawing many pixels
 	pixel draw_newton_fractal(
 		real_t x, real_t y,
 		const std::vector<std::array<real_t, 2>>& roots,
@@ -48,4 +175,51 @@ namespace giulia {
 		unsigned int max_iter = 30,
 		real_t epsilon = 0.00000001);
 
+
+	// Lyapunov fractal of the logistic map x <- r x (1 - x), where r follows
+	// a periodic sequence of the letters A and B, taking the values of the
+	// two coordinates of the parameter plane
+	struct lyapunov_fractal {
+
+		public:
+
+			// Construct the fractal of the given <sequence> of A and B, estimating
+			// the exponent over at most <max_iter> iterations after <warmup>
+			// iterations are skipped, and stopping early once the estimate
+			// changes by less than <tolerance> between checks
+			lyapunov_fractal(
+				const std::string& sequence = "AB",
+				unsigned int max_iter = 2000,
+				unsigned int warmup = 200,
+				real_t tolerance = 0.0001);
+
+
+			// Draw the pixel with parameters (a, b), iterating its orbit alone
+			// @see draw, which should be preferred when drawing many pixels
+			pixel operator()(real_t a, real_t b) const;
+
+
+			// Draw <n> pixels at once, processing them in SIMD lanes
+			void draw(const real_t* a, const real_t* b, pixel* out, unsigned int n) const;
+
+
+			// Compute the Lyapunov exponents of <n> parameter pairs in SIMD lanes
+			void exponents(const real_t* a, const real_t* b, real_t* out, unsigned int n) const;
+
+
+			// Color a Lyapunov exponent, in shades of yellow for stable
+			// orbits and of blue for chaotic ones
+			static pixel shade(real_t exponent);
+
+
+		private:
+
+			// Whether each step of the sequence takes the parameter b
+			std::vector<bool> sequence;
+
+			unsigned int max_iter;
+			unsigned int warmup;
+			real_t tolerance;
+	};
+
 }
@@ -0,0 +1,174 @@
+#pragma once
+
+// Geometry buffers of raymarched scenes, decoupling marching from shading
+
+#include "sdf_scene.h"
+#include "image.h"
+#include "common.h"
+#include <vector>
+#include <functional>
+
+
+namespace giulia {
+
+
+	// The surface seen through a pixel, before shading
+	struct gbuffer_sample {
+
+		// Distance along the ray to the hit point, infinite if the ray missed
+		real_t depth {theoretica::inf()};
+
+		// Unit normal to the surface
+		vec3 normal {0, 0, 0};
+
+		// Object material
+		unsigned int material {0};
+
+		// Number of marching steps to the hit point
+		unsigned int steps {0};
+
+		// Base color of the object, before any shading
+		pixel color;
+	};
+
+
+	// A geometry sampling function, taking normalized coordinates like draw functions
+	using gbuffer_function = std::function<gbuffer_sample(real_t, real_t, global_state&)>;
+
+
+	// A directional light
+	struct gbuffer_light {
+
+		// Direction toward the light
+		vec3 direction {0, 0, 1};
+
+		// Color and intensity of the light
+		pixel color {255, 255, 255};
+		real_t intensity {1};
+	};
+
+
+	// Parameters of the shading pass over a geometry buffer. The defaults
+	// give the same colors as raymarch(), with ambient occlusion only.
+	struct gbuffer_shading {
+
+		// Ambient occlusion by the step count out of <max_steps>
+		bool occlusion {true};
+		unsigned int max_steps {100};
+
+		// Ambient light, added to the diffuse light of each light
+		real_t ambient {1};
+		std::vector<gbuffer_light> lights;
+
+		// Exponential fog, of <fog_density> per unit of depth
+		real_t fog_density {0};
+		pixel fog_color;
+
+		// Color of the pixels whose ray missed every object
+		pixel background;
+	};
+
+
+	// A float buffer of the surfaces seen through the pixels of an image,
+	// stored as separate planes, so that a frame may be shaded again
+	// without marching it again
+	struct geometry_buffer {
+
+		public:
+
+			// Construct a buffer of width <w> and height <h>
+			geometry_buffer(unsigned int w = 0, unsigned int h = 0);
+
+
+			// Get the sample at index <i>
+			gbuffer_sample get_sample(unsigned int i) const;
+
+
+			// Set the sample at index <i>
+			void set_sample(unsigned int i, const gbuffer_sample& s);
+
+
+			// Get width of the buffer
+			unsigned int get_width() const;
+
+
+			// Get height of the buffer
+			unsigned int get_height() const;
+
+
+			// Get total sample size of the buffer
+			unsigned int get_size() const;
+
+
+			// Get raw pointer to the depth plane
+			const float* get_depth() const;
+
+
+			// Shade the buffer into an image of the same size
+			void shade(image& img, const gbuffer_shading& shading) const;
+
+
+		private:
+			unsigned int width {0};
+			unsigned int height {0};
+
+			// Sample planes
+			std::vector<float> depth;
+			std::vector<float> normal_x;
+			std::vector<float> normal_y;
+			std::vector<float> normal_z;
+			std::vector<float> material;
+			std::vector<float> steps;
+			std::vector<float> color_r;
+			std::vector<float> color_g;
+			std::vector<float> color_b;
+	};
+
+
+	// Raymarch the scene stepping by <d>, with the same march() as
+	// raymarch_split(), and get the surface hit by the ray, querying <shade>
+	// for its color and material. The normal is exact when the distance
+	// <dd> over multidual points is given, and estimated otherwise.
+	template<typename Distance, typename Shade, typename DualDistance = std::nullptr_t>
+	inline gbuffer_sample raymarch_gbuffer(
+		const Distance& d,
+		const Shade& shade,
+		vec3 camera,
+		vec3 direction = vec3({0, 0, -1}),
+		real min_distance = 0.001,
+		unsigned int max_steps = 100,
+		real max_distance = theoretica::inf(),
+		const DualDistance& dd = nullptr) {
+
+		gbuffer_sample s;
+		const march_result r = march(d, camera, direction, min_distance, max_steps, max_distance);
+
+		if(!r.hit)
+			return s;
+
+		const de_object obj = shade(r.position);
+
+		s.depth = r.distance;
+		s.normal = normal_hit(d, dd, r.position, min_distance);
+		s.material = obj.material;
+		s.steps = r.steps;
+		s.color = obj.color;
+
+		return s;
+	}
+
+
+	// Raymarch the scene <f> and get the surface hit by the ray
+	gbuffer_sample raymarch_gbuffer(
+		SDF f,
+		vec3 camera,
+		vec3 direction = vec3({0, 0, -1}),
+		real min_distance = 0.001,
+		unsigned int max_steps = 100);
+
+
+	// Sample every pixel of a buffer in parallel, using the same
+	// normalized coordinates as the rendering of images
+	void compute_gbuffer(geometry_buffer& g, global_state& state, gbuffer_function sample);
+
+}
@@ -106,6 +106,11 @@ namespace giulia {
 	using draw_function = std::function<pixel(real_t, real_t, global_state&)>;
 
 
+	// Get the normalized Cartesian coordinates of the pixel at index <i>
+	// of a <w> x <h> image, with the origin at the center of the image
+	void pixel_coords(unsigned int i, unsigned int w, unsigned int h, real_t& x, real_t& y);
+
+
 	// Apply a pixel modification to an image
 	void apply(image& img, std::function<pixel(pixel)> f);
 
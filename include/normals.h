@@ -0,0 +1,127 @@
+#pragma once
+
+// Estimation of the normals to signed distance surfaces
+//
+// The normal to a surface is the gradient of its signed distance function.
+// It may be estimated by finite differences around the hit point, with
+// steps on the scale of the hit tolerance, or computed exactly by
+// evaluating the distance once over multidual numbers, which carry
+// the derivatives along the three coordinates.
+
+#include "raymarching.h"
+#include "theoretica/autodiff/multidual.h"
+#include "theoretica/autodiff/multidual_functions.h"
+#include <functional>
+#include <cstddef>
+
+
+namespace giulia {
+
+
+	// A multidual number carrying the gradient over the coordinates of space
+	using dual3 = theoretica::multidual<3>;
+
+
+	// A point of space carrying the derivatives of its coordinates
+	using dual_vec3 = theoretica::vec<3, dual3>;
+
+
+	// A signed distance function evaluated together with its gradient
+	using dual_SDF = std::function<dual3(dual_vec3)>;
+
+
+	// Pack the point <p> as the variables of differentiation
+	inline dual_vec3 dual_point(vec3 p) {
+		return dual3::pack_function_arg(p);
+	}
+
+
+	// Normal to the surface of <d> at <p> by central differences
+	// with a step of <h>, taking six evaluations of the distance
+	template<typename Distance>
+	inline vec3 normal_central(const Distance& d, vec3 p, real h) {
+
+		return vec3({
+			d(p + vec3({h, 0, 0})) - d(p - vec3({h, 0, 0})),
+			d(p + vec3({0, h, 0})) - d(p - vec3({0, h, 0})),
+			d(p + vec3({0, 0, h})) - d(p - vec3({0, 0, h}))
+		}).normalized();
+	}
+
+
+	// Normal to the surface of <d> at <p> by finite differences over the
+	// vertices of a tetrahedron of size <h>, taking four evaluations of the
+	// distance. The vertices are not paired with their opposites, so that
+	// the curvature of the surface leaves an error of first order in <h>,
+	// while central differences are of second order.
+	template<typename Distance>
+	inline vec3 normal_tetrahedral(const Distance& d, vec3 p, real h) {
+
+		const real a = d(p + vec3({h, -h, -h}));
+		const real b = d(p + vec3({-h, -h, h}));
+		const real c = d(p + vec3({-h, h, -h}));
+		const real e = d(p + vec3({h, h, h}));
+
+		return vec3({
+			a - b - c + e,
+			-a - b + c + e,
+			-a + b - c + e
+		}).normalized();
+	}
+
+
+	// Exact normal to the surface of <d> at <p>, evaluating the distance
+	// once over multidual numbers, as the gradient of the distance
+	template<typename DualDistance>
+	inline vec3 normal_exact(const DualDistance& d, vec3 p) {
+		return d(dual_point(p)).Dual().normalized();
+	}
+
+
+	// Normal to the surface of <d> at a point <p> hit within <h> of it,
+	// by finite differences over a tetrahedron when no distance over
+	// multidual numbers is given
+	template<typename Distance>
+	inline vec3 normal_hit(const Distance& d, std::nullptr_t, vec3 p, real h) {
+		return normal_tetrahedral(d, p, h);
+	}
+
+
+	// Exact normal to the surface at a hit point <p>, when the
+	// distance <dd> over multidual numbers is given
+	template<typename Distance, typename DualDistance>
+	inline vec3 normal_hit(const Distance&, const DualDistance& dd, vec3 p, real) {
+		return normal_exact(dd, p);
+	}
+
+
+	// Signed distance functions over multidual numbers
+	namespace sdf {
+
+
+		// Distance to the union of objects
+		dual3 obj_union(dual3 a, dual3 b);
+
+
+		// Distance to the blend of objects
+		dual3 obj_blend(dual3 a, dual3 b, real k);
+
+
+		// Distance to the intersection of objects
+		dual3 obj_intersection(dual3 a, dual3 b);
+
+
+		// Distance to the object difference
+		dual3 obj_difference(dual3 a, dual3 b);
+
+
+		// Distance to the sphere
+		dual3 sphere(dual_vec3 pos, vec3 center, real radius);
+
+
+		// Distance to the Mandelbulb fractal
+		dual3 mandelbulb_distance(dual_vec3 pos);
+
+	}
+
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+// Newton and Nova fractals of arbitrary holomorphic functions
+
+#define THEORETICA_LONG_DOUBLE_PREC
+#include "theoretica/autodiff/complex_dual_functions.h"
+using theoretica::complex_dual;
+
+#include "common.h"
+#include "image.h"
+#include "palette.h"
+#include <functional>
+
+
+namespace giulia {
+
+
+	// A holomorphic function evaluated on complex dual numbers,
+	// so that the dual part of the result is its exact derivative
+	using holomorphic_function = std::function<complex_dual(complex_dual)>;
+
+
+	// Iterate z <- z - relaxation * f(z) / f'(z) + c from (z_a, z_b), with the
+	// derivative from the same evaluation of <f>, until two iterates are closer
+	// than <epsilon>. Returns the number of iterations, or <max_iter> when the
+	// orbit does not converge.
+	unsigned int nova_iterate(
+		real_t& z_a, real_t& z_b, real_t c_a, real_t c_b,
+		holomorphic_function f, real_t relaxation,
+		unsigned int max_iter, real_t epsilon);
+
+
+	// Draw the Newton fractal of <f>, coloring each pixel through the cyclic
+	// palette <p> by the argument of the root its orbit converges to,
+	// darker the slower it converges
+	pixel draw_newton_function(
+		real_t x, real_t y, holomorphic_function f, const palette& p,
+		real_t relaxation = 1, unsigned int max_iter = 50, real_t epsilon = 1E-8);
+
+
+	// Draw the Nova fractal of <f> with parameter c = (x, y), iterating from
+	// the critical point (z_a, z_b) and coloring through the palette <p>
+	// by the number of iterations the orbit takes to converge
+	pixel draw_nova(
+		real_t x, real_t y, holomorphic_function f, const palette& p,
+		real_t relaxation = 1, real_t z_a = 1, real_t z_b = 0,
+		unsigned int max_iter = 50, real_t epsilon = 1E-8);
+
+}
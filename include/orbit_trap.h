@@ -0,0 +1,124 @@
+#pragma once
+
+// Orbit traps for escape-time fractals
+
+#include "common.h"
+#include "simd.h"
+#include <vector>
+
+
+namespace giulia {
+
+
+	// Shape of an orbit trap
+	enum orbit_trap_type {
+		TRAP_POINT,
+		TRAP_LINE,
+		TRAP_CIRCLE,
+		TRAP_CROSS
+	};
+
+
+	// An orbit trap in the complex plane
+	struct orbit_trap {
+
+		orbit_trap_type type {TRAP_POINT};
+
+		// Center of the trap, or a point on the line for line traps
+		real_t x {0};
+		real_t y {0};
+
+		// Angle of the line or of the cross arms, in radians
+		real_t angle {0};
+
+		// Radius of circle traps
+		real_t radius {0};
+
+
+		// A point trap at (x, y)
+		inline static orbit_trap point(real_t x, real_t y) {
+			orbit_trap t;
+			t.type = TRAP_POINT;
+			t.x = x; t.y = y;
+			return t;
+		}
+
+		// A line trap passing through (x, y) with the given angle
+		inline static orbit_trap line(real_t x, real_t y, real_t angle = 0) {
+			orbit_trap t;
+			t.type = TRAP_LINE;
+			t.x = x; t.y = y;
+			t.angle = angle;
+			return t;
+		}
+
+		// A circle trap centered at (x, y)
+		inline static orbit_trap circle(real_t x, real_t y, real_t radius) {
+			orbit_trap t;
+			t.type = TRAP_CIRCLE;
+			t.x = x; t.y = y;
+			t.radius = radius;
+			return t;
+		}
+
+		// A cross trap centered at (x, y), with arms rotated by the given angle
+		inline static orbit_trap cross(real_t x, real_t y, real_t angle = 0) {
+			orbit_trap t;
+			t.type = TRAP_CROSS;
+			t.x = x; t.y = y;
+			t.angle = angle;
+			return t;
+		}
+	};
+
+
+	// Escape-time iteration of z_i+1 = z_i^2 + c tracking the minimum
+	// distance of the orbit to a set of traps. Traps are laid out across
+	// SIMD lanes and compared by squared distance, taking a single
+	// square root per trap at the end of the orbit.
+	struct orbit_trap_engine {
+
+		public:
+
+			// Number of packs of traps kept in registers along an orbit.
+			// Engines with more packs iterate the orbit once per block of them.
+			static constexpr unsigned int block_packs = 16;
+
+
+			// Construct an engine for the given traps with escape radius <R>
+			orbit_trap_engine(const std::vector<orbit_trap>& traps, real_t R = 2);
+
+
+			// Iterate from z_0 = (z_a, z_b) with parameter (c_a, c_b), writing the
+			// minimum distance to each trap into <dist>, starting from <init_dist>.
+			// Returns the number of iterations and leaves the last iterate in (z_a, z_b).
+			unsigned int iterate(
+				real_t& z_a, real_t& z_b, real_t c_a, real_t c_b,
+				real_t* dist, unsigned int max_iter, real_t init_dist = 2) const;
+
+
+			// Get the number of traps
+			unsigned int size() const;
+
+
+			// Get the escape radius
+			real_t radius() const;
+
+		private:
+
+			// Traps in structure of arrays layout, grouped by shape
+			// into packs of the SIMD width: position, unit direction and radius
+			std::vector<double> px, py, dx, dy, r;
+
+			// Shape of the traps in each pack
+			std::vector<orbit_trap_type> pack_type;
+
+			// Lane of each trap, in the order they were given
+			std::vector<unsigned int> slot;
+
+			unsigned int n_traps;
+			unsigned int n_packs;
+			real_t R;
+	};
+
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+// Gradient palettes baked into color lookup tables
+
+#include "common.h"
+#include "image.h"
+#include "field.h"
+#include <cmath>
+#include <vector>
+
+
+namespace giulia {
+
+
+	// Mapping of palette coordinates onto the lookup table
+	enum palette_mode {
+
+		// Values outside [0, 1] take the color of the nearest end
+		PALETTE_CLAMP,
+
+		// Values wrap around, repeating the gradient
+		PALETTE_CYCLIC,
+
+		// Values are quantized to a fixed number of bands, wrapping around
+		PALETTE_BANDED
+	};
+
+
+	// A color stop of a gradient
+	struct palette_stop {
+
+		// Position of the stop in [0, 1]
+		real_t position;
+
+		// Color at the stop
+		pixel color;
+	};
+
+
+	// A multi-stop gradient baked into a fixed-size lookup table,
+	// so that coloring is an index computation and a table fetch
+	struct palette {
+
+		public:
+
+			// Default number of entries of the lookup table
+			static constexpr unsigned int default_size = 4096;
+
+
+			// Construct a palette from gradient stops, linearly interpolated
+			palette(
+				const std::vector<palette_stop>& stops,
+				palette_mode mode = PALETTE_CLAMP,
+				unsigned int size = default_size,
+				unsigned int bands = 16);
+
+
+			// Get the color at coordinate <t>, where [0, 1] spans the gradient
+			inline pixel operator()(float t) const {
+
+				float u = t * size;
+
+				if(mode == PALETTE_BANDED)
+					u = std::floor(t * bands) * band_width;
+
+				// NaN coordinates map to the first entry
+				if(!(u >= 0 || u < 0))
+					return lut[0];
+
+				if(mode == PALETTE_CLAMP)
+					return lut[u <= 0 ? 0 : (u >= size - 1 ? size - 1 : (unsigned int) u)];
+
+				// Wrap around, also for negative coordinates
+				u -= size * std::floor(u * inv_size);
+				const unsigned int i = (unsigned int) u;
+
+				return lut[i < size ? i : 0];
+			}
+
+
+			// Get the entry at index <i> of the lookup table
+			pixel get(unsigned int i) const;
+
+
+			// Get the number of entries of the lookup table
+			unsigned int get_size() const;
+
+
+			// Black to white gradient
+			static palette grayscale(palette_mode mode = PALETTE_CLAMP);
+
+
+			// Cyclic gradient of the colors of Giulia's fractal
+			static palette giulia_present(palette_mode mode = PALETTE_CYCLIC);
+
+
+		private:
+			std::vector<pixel> lut;
+			unsigned int size;
+			palette_mode mode;
+			unsigned int bands;
+			float band_width;
+			float inv_size;
+	};
+
+
+	// Color a field sample by its smooth iteration count, mapped to
+	// palette coordinates as iter / max_iter * scale + offset
+	pixel shade_palette(
+		const field_sample& s, const palette& p,
+		unsigned int max_iter, real_t scale = 1, real_t offset = 0);
+
+
+	// Color a whole field through a palette
+	void shade_field(
+		const iteration_field& f, image& img, const palette& p,
+		real_t scale = 1, real_t offset = 0);
+
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+// Cone-marching depth prepass of primary rays
+
+#include "raymarching.h"
+#include "common.h"
+#include <vector>
+#include <functional>
+
+
+namespace giulia {
+
+
+	// A camera model, giving the unit direction of the primary ray
+	// through the normalized coordinates (x, y)
+	using camera_function = std::function<vec3(real_t, real_t)>;
+
+
+	// Safe starting distances of the primary rays of an image, found by
+	// marching one cone through the footprint of each block of pixels.
+	// A cone only advances by the part of the distance estimate which
+	// exceeds its own width, so that it stops in front of the first
+	// surface met by any of its rays. Blocks are refined hierarchically,
+	// each cone starting from the depth of the cone of its parent block.
+	// Depths are interpolated between blocks, from the lowest depth around
+	// each block, so that they are safe and continuous over the image.
+	struct depth_prepass {
+
+		public:
+
+			// Construct a prepass over the normalized coordinates of a <width> x
+			// <height> image, with cones over blocks of <block> pixels, refined
+			// down to blocks of <min_block> pixels
+			depth_prepass(
+				unsigned int width, unsigned int height,
+				unsigned int block = 16, unsigned int min_block = 4);
+
+
+			// March the cones of the scene <d> from <camera>, with rays in the
+			// directions given by <direction>, until they are closer than
+			// <min_distance> to a surface or after <max_steps> steps
+			void march(
+				distance_SDF d, vec3 camera, camera_function direction,
+				real min_distance = 0.001, unsigned int max_steps = 100);
+
+
+			// Get the safe starting distance of the ray through the normalized
+			// coordinates (x, y), which may start marching from
+			// camera + direction * get_depth(x, y)
+			real get_depth(real_t x, real_t y) const;
+
+
+			// Raymarch the ray through the normalized coordinates (x, y) from its
+			// starting distance, stepping by the distance function of the prepass
+			// and querying <shade> at the hit point. Ambient occlusion only counts
+			// the steps taken from the starting distance.
+			pixel raymarch(
+				SDF shade, real_t x, real_t y,
+				pixel background = pixel(0, 0, 0),
+				real min_distance = 0.001,
+				unsigned int max_steps = 100,
+				bool lighting = false) const;
+
+
+		private:
+
+			unsigned int width;
+			unsigned int height;
+			unsigned int block;
+			unsigned int min_block;
+
+			// Size of the blocks, number of blocks along each axis
+			// and depth of each block, by rows, at the finest level
+			unsigned int block_size {0};
+			unsigned int blocks_x {0};
+			unsigned int blocks_y {0};
+			std::vector<real> depths;
+
+			// Scene and camera of the last march
+			distance_SDF d;
+			vec3 camera;
+			camera_function direction;
+
+
+			// Bounds of the normalized coordinates of the block (bx, by)
+			// of <size> pixels
+			void block_bounds(
+				unsigned int size, unsigned int bx, unsigned int by,
+				real_t& x_min, real_t& y_min, real_t& x_max, real_t& y_max) const;
+	};
+
+}
@@ -5,6 +5,9 @@
 using theoretica::vec3;
 using theoretica::real;
 
+#include "theoretica/interval/interval.h"
+using theoretica::interval;
+
 #include "image.h"
 #include <functional>
 
@@ -43,6 +46,20 @@ namespace giulia {
 	using SDF = std::function<de_object(vec3)>;
 
 
+	// A signed distance function giving only the distance, for marching,
+	// while the full object is only queried once at the hit point
+	using distance_SDF = std::function<real(vec3)>;
+
+
+	// An axis aligned box of space, as a vector of intervals
+	using box3 = theoretica::vec<3, interval>;
+
+
+	// A signed distance function bounded over boxes of space
+	// by interval arithmetic
+	using interval_SDF = std::function<interval(box3)>;
+
+
 	// Raymarching routine
 	pixel raymarch(
 		SDF f,
@@ -54,6 +71,48 @@ namespace giulia {
 		bool lighting = false);
 
 
+	// Raymarching routine stepping by the distance-only function <d>
+	// and querying <shade> for the color of the object at the hit point
+	pixel raymarch(
+		distance_SDF d,
+		SDF shade,
+		vec3 camera,
+		vec3 direction = vec3({0, 0, -1}),
+		pixel background = pixel(0, 0, 0),
+		real min_distance = 0.001,
+		unsigned int max_steps = 100,
+		bool lighting = false);
+
+
+	// Raymarching routine by over-relaxed sphere tracing, stepping by
+	// <relaxation> times the distance and stepping back when consecutive
+	// spheres do not overlap, with a hit tolerance of <pixel_radius> times
+	// the distance from the camera and a far plane at <far>
+	pixel raymarch_relaxed(
+		SDF f,
+		vec3 camera,
+		vec3 direction = vec3({0, 0, -1}),
+		pixel background = pixel(0, 0, 0),
+		real relaxation = 1.6,
+		real pixel_radius = 0.001,
+		real far = 100,
+		unsigned int max_steps = 100,
+		real grazing = 4,
+		bool lighting = false);
+
+
+	// Whether all the rays camera + s * d, with d in the convex hull of the
+	// four directions <corners> and s up to <far>, provably miss the surfaces
+	// of <f>. The frustum is marched in segments whose bounding boxes have
+	// a lower bound on their distance above <min_distance>, as raymarching
+	// counts a hit as soon as a ray comes within <min_distance> of a surface.
+	// The scene must lie within <far> of the camera for the rays to miss it.
+	bool frustum_empty(
+		interval_SDF f, vec3 camera, const vec3 corners[4],
+		real far = 100, unsigned int max_steps = 128,
+		real min_distance = 0.001);
+
+
 	// Signed distance functions
 	namespace sdf {
 
@@ -85,6 +144,58 @@ namespace giulia {
 		// SDF for the Mandelbulb fractal
 		de_object mandelbulb(vec3 pos);
 
+
+		// Distance to the union of objects
+		real obj_union(real a, real b);
+
+
+		// Distance to the blend of objects
+		real obj_blend(real a, real b, real k);
+
+
+		// Distance to the intersection of objects
+		real obj_intersection(real a, real b);
+
+
+		// Distance to the object difference
+		real obj_difference(real a, real b);
+
+
+		// Distance to the sphere
+		real sphere(vec3 pos, vec3 center, real radius);
+
+
+		// Distance to the Mandelbulb fractal of the given <power>, after at most
+		// <iterations> iterations, by the polar form of the power of the point
+		real mandelbulb_distance(vec3 pos, unsigned int power = 8, unsigned int iterations = 10);
+
+
+		// Distance to the Mandelbulb fractal of the given integer <power>,
+		// as by mandelbulb_distance(), computing the multiples of the polar
+		// angles as powers of unit complex numbers, without trigonometric
+		// functions
+		real mandelbulb_polynomial(vec3 pos, unsigned int power = 8, unsigned int iterations = 10);
+
+
+		// Bound the union of objects over a box
+		interval obj_union(interval a, interval b);
+
+
+		// Bound the blend of objects over a box
+		interval obj_blend(interval a, interval b, real k);
+
+
+		// Bound the intersection of objects over a box
+		interval obj_intersection(interval a, interval b);
+
+
+		// Bound the object difference over a box
+		interval obj_difference(interval a, interval b);
+
+
+		// Bound the SDF of the sphere over a box
+		interval sphere(box3 pos, vec3 center, real radius);
+
 	}
 	
 }
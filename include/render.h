@@ -0,0 +1,68 @@
+#pragma once
+
+// Rendering of images from draw functions
+
+#include "common.h"
+#include "image.h"
+#include <functional>
+
+
+namespace giulia {
+
+
+	// Symmetry of a scene, declared through state["symmetry"]
+	enum symmetry_mode {
+
+		// No symmetry, every pixel is drawn
+		SYMMETRY_NONE = 0,
+
+		// Mirror symmetry about the horizontal line y = state["symmetry.y"]
+		SYMMETRY_MIRROR_X = 1,
+
+		// Mirror symmetry about the vertical line x = state["symmetry.x"]
+		SYMMETRY_MIRROR_Y = 2,
+
+		// Point symmetry about (state["symmetry.x"], state["symmetry.y"])
+		SYMMETRY_POINT = 3,
+
+		// Rotational symmetry of order state["symmetry.order"]
+		// about (state["symmetry.x"], state["symmetry.y"])
+		SYMMETRY_ROTATION = 4
+	};
+
+
+	// Render an image by drawing every pixel in parallel, with the supersampling
+	// level of state["supersampling"]. When the scene declares a symmetry,
+	// with its center in normalized coordinates, pixels are sampled at
+	// symmetric_coords() instead and only one pixel of each set of pixels
+	// mapped onto each other is drawn, the others being copied from it.
+	// Rotations are only used by half or quarter turns, which map pixels
+	// onto pixels, so that orders which are not even draw every pixel.
+	void render(image& img, global_state& state, draw_function draw);
+
+
+	// Get the normalized coordinates at which render() samples the pixel at
+	// index <i> of a symmetric scene. These follow pixel_coords() without its
+	// shift along each row, moved by less than a pixel so that the center of
+	// the symmetry lies on a pixel center, edge or corner.
+	void symmetric_coords(
+		unsigned int i, unsigned int w, unsigned int h,
+		global_state& state, real_t& x, real_t& y);
+
+
+	// A test of whether a region [x_min, x_max] x [y_min, y_max] of normalized
+	// coordinates is provably drawn with a single color, which is set in <fill>
+	using cull_function = std::function<bool(
+		real_t x_min, real_t y_min, real_t x_max, real_t y_max,
+		global_state& state, pixel& fill)>;
+
+
+	// Render an image by square tiles of <tile> pixels, flat filling the tiles
+	// which <cull> proves uniform over their whole footprint, including the
+	// supersampling offsets, and drawing the others pixel by pixel.
+	// The number of filled tiles is written to state["culled"].
+	void render_culled(
+		image& img, global_state& state, draw_function draw,
+		cull_function cull, unsigned int tile = 16);
+
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+// Bounding volume hierarchies over signed distance primitives
+
+#include "raymarching.h"
+#include <vector>
+
+
+namespace giulia {
+
+
+	// A scene of many signed distance primitives, each enclosed by a bounding
+	// sphere, organized in a tree of axis aligned boxes. Distance queries
+	// visit the nearest boxes first and skip any box farther than the best
+	// distance found so far, so that only the primitives around the query
+	// point are evaluated.
+	struct sdf_bvh {
+
+		public:
+
+			// Add a primitive given by <f>, which lies within <radius> of <center>.
+			// Returns the index of the primitive.
+			unsigned int add(SDF f, vec3 center, real radius);
+
+
+			// Add a sphere, whose distance is evaluated without calling any SDF.
+			// Returns the index of the primitive.
+			unsigned int add_sphere(vec3 center, real radius, pixel color);
+
+
+			// Build the tree over the primitives added so far,
+			// with at most <leaf_size> primitives per leaf
+			void build(unsigned int leaf_size = 4);
+
+
+			// Distance to the nearest primitive
+			real distance(vec3 p) const;
+
+
+			// Nearest primitive, with its distance and color
+			de_object operator()(vec3 p) const;
+
+
+			// Find the distances <t_enter> and <t_exit> along the ray from <origin>
+			// with direction <direction> of the points where it enters and leaves
+			// the bounds of the scene, returning false when it misses them
+			bool intersect(vec3 origin, vec3 direction, real& t_enter, real& t_exit) const;
+
+
+			// Raymarch the scene, starting where the ray enters its bounds
+			// and stopping where it leaves them
+			pixel raymarch(
+				vec3 camera,
+				vec3 direction = vec3({0, 0, -1}),
+				pixel background = pixel(0, 0, 0),
+				real min_distance = 0.001,
+				unsigned int max_steps = 100,
+				bool lighting = false) const;
+
+
+			// Get the number of primitives
+			unsigned int size() const;
+
+
+		private:
+
+			// A primitive and its bounding sphere
+			struct primitive {
+				SDF f;
+				vec3 center;
+				real radius;
+				pixel color;
+			};
+
+			// A box of the tree, with either two children or a range of primitives
+			struct node {
+				vec3 lo;
+				vec3 hi;
+				unsigned int left;
+				unsigned int right;
+				unsigned int first;
+				unsigned int count;
+			};
+
+			std::vector<primitive> primitives;
+			std::vector<unsigned int> order;
+			std::vector<node> nodes;
+
+			// Build the subtree over order[first, first + count)
+			unsigned int build_node(unsigned int first, unsigned int count, unsigned int leaf_size);
+
+			// Distance to the nearest primitive and its index
+			real nearest(vec3 p, unsigned int& index) const;
+	};
+
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+// Sparse grids caching expensive signed distance functions
+
+#include "raymarching.h"
+#include <string>
+#include <vector>
+#include <cstdint>
+
+
+namespace giulia {
+
+
+	// A signed distance function baked into a sparse grid of bricks over a
+	// box of space. Bricks far from the surface only store the distance at
+	// their center, which bounds the distance over the whole brick, while
+	// bricks near the surface store a dense block of samples, interpolated
+	// trilinearly and lowered by sqrt(3) cells, the most the interpolant may
+	// overstate the distance by. Lookups whose bound is below the refinement
+	// distance are evaluated exactly, so that hit points and normals are
+	// those of the original function. The surface must lie within the box.
+	struct sdf_grid {
+
+		public:
+
+			// Construct a grid over the box [lo, hi], with <resolution> cells
+			// along its longest side, in bricks of <brick> x <brick> x <brick>
+			// cells, refining lookups whose bound is below <refine>,
+			// or than two cells when <refine> is not positive
+			sdf_grid(
+				vec3 lo = vec3(-1.5), vec3 hi = vec3(1.5),
+				unsigned int resolution = 128, unsigned int brick = 8,
+				real refine = 0);
+
+
+			// Bake the distance function <d> into the grid in parallel,
+			// keeping it to evaluate lookups near the surface
+			void bake(distance_SDF d);
+
+
+			// Set the distance function evaluated near the surface,
+			// as after loading a grid, or disable refinement if empty
+			void set_exact(distance_SDF d);
+
+
+			// Distance to the surface
+			real distance(vec3 p) const;
+
+
+			// Raymarch the grid, querying <shade> at the hit point
+			pixel raymarch(
+				SDF shade,
+				vec3 camera,
+				vec3 direction = vec3({0, 0, -1}),
+				pixel background = pixel(0, 0, 0),
+				real min_distance = 0.001,
+				unsigned int max_steps = 100,
+				bool lighting = false) const;
+
+
+			// Get the total number of bricks
+			unsigned int get_bricks() const;
+
+
+			// Get the number of bricks storing dense samples
+			unsigned int get_dense_bricks() const;
+
+
+			// Save the grid to a compact binary file, returning 0 on success
+			int save(const std::string& filename) const;
+
+
+			// Load a grid from a file written by save(), returning 0 on success.
+			// The exact distance function is not saved and must be set again.
+			int load(const std::string& filename);
+
+
+		private:
+
+			vec3 lo;
+			real spacing;
+			real refine;
+			unsigned int brick;
+
+			// Number of bricks along each axis
+			unsigned int bricks_x {0};
+			unsigned int bricks_y {0};
+			unsigned int bricks_z {0};
+
+			// Distance at the center of each brick, by rows
+			std::vector<float> centers;
+
+			// Index of the samples of each brick, or -1 for sparse bricks
+			std::vector<int32_t> index;
+
+			// Dense samples of (brick + 1)^3 floats per brick
+			std::vector<float> samples;
+
+			distance_SDF exact;
+
+
+			// Distance from the grid alone, at a point within its bounds
+			real lookup(double x, double y, double z) const;
+
+			// Position of the sample (i, j, k) of the brick (bx, by, bz)
+			vec3 sample_position(
+				unsigned int bx, unsigned int by, unsigned int bz,
+				unsigned int i, unsigned int j, unsigned int k) const;
+	};
+
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+// Packet raymarching of coherent rays in SIMD lanes
+
+#include "raymarching.h"
+#include "simd.h"
+#include <functional>
+
+
+namespace giulia {
+
+
+	// A pack of N points or directions of space, one per lane
+	template<unsigned int N>
+	struct simd_vec3 {
+
+		simd_vec<N> x;
+		simd_vec<N> y;
+		simd_vec<N> z;
+
+		simd_vec3() {}
+
+		simd_vec3(const simd_vec<N>& x, const simd_vec<N>& y, const simd_vec<N>& z)
+			: x(x), y(y), z(z) {}
+
+		// Broadcast a vector to all lanes
+		simd_vec3(vec3 v) : x((double) v[0]), y((double) v[1]), z((double) v[2]) {}
+
+		inline simd_vec3 operator+(const simd_vec3& other) const {
+			return simd_vec3(x + other.x, y + other.y, z + other.z);
+		}
+
+		inline simd_vec3 operator-(const simd_vec3& other) const {
+			return simd_vec3(x - other.x, y - other.y, z - other.z);
+		}
+
+		// Scale each lane by the corresponding lane of <s>
+		inline simd_vec3 operator*(const simd_vec<N>& s) const {
+			return simd_vec3(x * s, y * s, z * s);
+		}
+
+		inline simd_vec<N> square_length() const {
+			return x * x + y * y + z * z;
+		}
+
+		inline simd_vec<N> length() const {
+			return simd::sqrt(square_length());
+		}
+
+		// Get the vector of lane <l>
+		inline vec3 get(unsigned int l) const {
+			return vec3({x[l], y[l], z[l]});
+		}
+
+		// Set the vector of lane <l>
+		inline void set(unsigned int l, vec3 v) {
+			x[l] = v[0];
+			y[l] = v[1];
+			z[l] = v[2];
+		}
+	};
+
+
+	// Default pack of vectors
+	using simd_real3 = simd_vec3<GIULIA_SIMD_WIDTH>;
+
+
+	// A signed distance function evaluated on a pack of points at once
+	using packet_SDF = std::function<simd_real(const simd_real3&)>;
+
+
+	// Raymarch <n> rays from <camera> with the given <directions>, in packets
+	// of SIMD lanes stepping by <d>, each lane stopping on its own. Colors are
+	// queried from <shade> once at each hit point, as by raymarch().
+	// Packets whose directions diverge by more than <coherence> radians
+	// fall back to scalar marching of <shade>.
+	void raymarch_packet(
+		packet_SDF d, SDF shade,
+		vec3 camera, const vec3* directions, pixel* out, unsigned int n,
+		pixel background = pixel(0, 0, 0),
+		real min_distance = 0.001,
+		unsigned int max_steps = 100,
+		real coherence = 0.05);
+
+
+	// Signed distance functions over packs of points
+	namespace sdf {
+
+
+		// Distance to the union of objects
+		simd_real obj_union(const simd_real& a, const simd_real& b);
+
+
+		// Distance to the blend of objects
+		simd_real obj_blend(const simd_real& a, const simd_real& b, real k);
+
+
+		// Distance to the intersection of objects
+		simd_real obj_intersection(const simd_real& a, const simd_real& b);
+
+
+		// Distance to the object difference
+		simd_real obj_difference(const simd_real& a, const simd_real& b);
+
+
+		// Distance to the sphere
+		simd_real sphere(const simd_real3& pos, vec3 center, real radius);
+
+
+		// Distance to the Mandelbulb fractal
+		simd_real mandelbulb(const simd_real3& pos);
+
+	}
+
+}
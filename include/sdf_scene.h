@@ -0,0 +1,501 @@
+#pragma once
+
+// Signed distance scenes composed at compile time
+//
+// A scene is a tree of small node types, each one knowing the type of its
+// children, so that a whole scene is a single type whose distance function
+// the compiler inlines into the marching loop, without going through
+// std::function at every step. Nodes provide distance(p), giving only the
+// distance, also over multidual points for exact normals, and operator()(p),
+// giving the full de_object with the same arithmetic as the runtime
+// sdf:: functions. The difference of objects also negates the distance of
+// the carved object it returns, so that both give the same distance.
+
+#include "raymarching.h"
+#include "normals.h"
+#include "theoretica/core/real_analysis.h"
+#include "theoretica/interpolation/spline_interp.h"
+
+
+namespace giulia {
+
+
+	// The end of a ray marched by march()
+	struct march_result {
+
+		// Whether the ray came within the hit tolerance of a surface
+		bool hit {false};
+
+		// Last point marched to, which is the hit point for rays that hit
+		vec3 position;
+
+		// Total distance marched along the ray
+		real distance {0};
+
+		// Number of steps before the hit, or all of them for rays that missed
+		unsigned int steps {0};
+
+		// Lowest distance to the surfaces along the ray
+		real minimum {10000000};
+	};
+
+
+	// Sphere trace the ray from <camera> along <direction> stepping by any
+	// callable <d> giving the distance, until a step is below <min_distance>,
+	// after at most <max_steps> steps. Rays marching past <max_distance>
+	// miss, as if they ran out of steps.
+	template<typename Distance>
+	inline march_result march(
+		const Distance& d,
+		vec3 camera,
+		vec3 direction,
+		real min_distance,
+		unsigned int max_steps,
+		real max_distance = theoretica::inf()) {
+
+		march_result r;
+		unsigned int i = 0;
+
+		for (i = 0; i < max_steps; i++) {
+
+			// Compute the current position
+			r.position = camera + direction * r.distance;
+
+			// Compute another step of distance estimation
+			const real distance = d(r.position);
+			r.distance += distance;
+
+			if(distance < r.minimum)
+				r.minimum = distance;
+
+			// Stop when close enough
+			if (distance < min_distance) {
+				r.hit = true;
+				break;
+			}
+
+			// Stop when past the far end of the ray
+			if (r.distance > max_distance) {
+				i = max_steps;
+				break;
+			}
+		}
+
+		r.steps = i;
+		return r;
+	}
+
+
+	// Color of the object hit at <pos> after <steps> steps out of <max_steps>,
+	// queried from <shade>, with simple ambient occlusion by the step count.
+	// Normals are exact when the distance <dd> over multidual points is
+	// given, and estimated on the scale of the hit tolerance <epsilon>
+	// by finite differences otherwise.
+	template<typename Distance, typename Shade, typename DualDistance = std::nullptr_t>
+	inline pixel shade_hit(
+		const Distance& d, const Shade& shade, vec3 pos, real tot_distance,
+		unsigned int steps, unsigned int max_steps, bool lighting, real epsilon,
+		const DualDistance& dd = nullptr) {
+
+		de_object obj = shade(pos);
+		obj.position = pos;
+
+		// Set the distance of the object to the total computed distance
+		obj.distance = tot_distance;
+
+		// Simple ambient occlusion
+		real coeff = theoretica::square(1 - steps / (real) max_steps);
+
+		obj.color = pixel(
+			theoretica::clamp(obj.color.r * coeff, 0, 255),
+			theoretica::clamp(obj.color.g * coeff, 0, 255),
+			theoretica::clamp(obj.color.b * coeff, 0, 255)
+		);
+
+		if(lighting)
+			obj.normal = normal_hit(d, dd, pos, epsilon);
+		else
+			obj.normal = {0, 0, 0};
+
+		return obj.color;
+	}
+
+
+	// Raymarching routine stepping by any callable <d> giving the distance,
+	// so that the loop only carries a few reals, and querying <shade>
+	// for the full object once at the hit point. Rays marching past
+	// <max_distance> are given the background color. Normals are exact
+	// when the distance <dd> over multidual points is given.
+	template<typename Distance, typename Shade, typename DualDistance = std::nullptr_t>
+	inline pixel raymarch_split(
+		const Distance& d,
+		const Shade& shade,
+		vec3 camera,
+		vec3 direction = vec3({0, 0, -1}),
+		pixel background = pixel(0, 0, 0),
+		real min_distance = 0.001,
+		unsigned int max_steps = 100,
+		bool lighting = false,
+		real max_distance = theoretica::inf(),
+		const DualDistance& dd = nullptr) {
+
+		const march_result r = march(d, camera, direction, min_distance, max_steps, max_distance);
+
+		if(!r.hit) {
+
+			// Soft border
+			// real border_gradient = (1 - r.minimum * 10);
+			// obj.color = pixel(
+			// 	clamp(obj.color.r * border_gradient, 0, 255),
+			// 	clamp(obj.color.g * border_gradient, 0, 255),
+			// 	clamp(obj.color.b * border_gradient, 0, 255)
+			// );
+
+			return background;
+		}
+
+		return shade_hit(
+			d, shade, r.position, r.distance, r.steps,
+			max_steps, lighting, min_distance, dd);
+	}
+
+
+	// Over-relaxed sphere tracing, stepping by <relaxation> times the distance
+	// by <d>. When two consecutive unbounding spheres do not overlap, the step
+	// may have skipped a surface, so the ray steps back and continues without
+	// relaxation. A point is hit when its distance is below <pixel_radius>
+	// times its distance from the camera, the radius of the pixel footprint,
+	// and rays past <far> are given the background color. When the steps run
+	// out, the point with the lowest footprint-relative distance is still
+	// taken as hit if it is within <grazing> footprints of the surface.
+	// Normals are exact when the distance <dd> over multidual points is given.
+	template<typename Distance, typename Shade, typename DualDistance = std::nullptr_t>
+	inline pixel raymarch_relaxed(
+		const Distance& d,
+		const Shade& shade,
+		vec3 camera,
+		vec3 direction = vec3({0, 0, -1}),
+		pixel background = pixel(0, 0, 0),
+		real relaxation = 1.6,
+		real pixel_radius = 0.001,
+		real far = 100,
+		unsigned int max_steps = 100,
+		real grazing = 4,
+		bool lighting = false,
+		const DualDistance& dd = nullptr) {
+
+		real omega = relaxation;
+		real t = 0;
+		real step = 0;
+		real previous_radius = 0;
+
+		// Best candidate for a hit, for grazing rays, and the step it was
+		// found at, so that its occlusion is not that of a ray out of steps
+		real candidate_t = 0;
+		real candidate_error = theoretica::inf();
+		unsigned int candidate_i = 0;
+
+		// Rays starting inside of an object march outwards
+		const real sign = d(camera) < 0 ? -1 : 1;
+
+		unsigned int i = 0;
+		bool hit = false;
+
+		for (i = 0; i < max_steps; i++) {
+
+			const real signed_radius = sign * d(camera + direction * t);
+			const real radius = theoretica::abs(signed_radius);
+
+			// Step back when the spheres of the last two steps do not overlap
+			const bool fail = omega > 1 && (radius + previous_radius) < step;
+
+			if(fail) {
+				step -= omega * step;
+				omega = 1;
+			} else {
+				step = signed_radius * omega;
+			}
+
+			previous_radius = radius;
+
+			if(!fail) {
+
+				const real error = radius / t;
+
+				if(error < candidate_error) {
+					candidate_t = t;
+					candidate_error = error;
+					candidate_i = i;
+				}
+
+				// Stop within the pixel footprint
+				if(error < pixel_radius) {
+					hit = true;
+					break;
+				}
+			}
+
+			if(t > far)
+				break;
+
+			t += step;
+		}
+
+		if(!hit && (t > far || candidate_error > pixel_radius * grazing))
+			return background;
+
+		return shade_hit(
+			d, shade, camera + direction * candidate_t,
+			candidate_t, candidate_i, max_steps, lighting, pixel_radius * candidate_t, dd);
+	}
+
+
+	// Raymarching routine over a compile-time scene, stepping
+	// by its distance only and shading the hit point, with exact
+	// normals from the distance of the scene over multidual points
+	template<typename Scene>
+	inline pixel raymarch_scene(
+		const Scene& scene,
+		vec3 camera,
+		vec3 direction = vec3({0, 0, -1}),
+		pixel background = pixel(0, 0, 0),
+		real min_distance = 0.001,
+		unsigned int max_steps = 100,
+		bool lighting = false) {
+
+		return raymarch_split(
+			[&scene](vec3 p) { return scene.distance(p); }, scene,
+			camera, direction, background, min_distance, max_steps, lighting,
+			theoretica::inf(),
+			[&scene](const dual_vec3& p) { return scene.distance(p); });
+	}
+
+
+	namespace sdf {
+
+
+		// Sphere of given center, radius and color
+		struct sphere_node {
+
+			vec3 center;
+			real radius;
+			pixel color;
+
+			inline real distance(vec3 p) const {
+				return (p - center).length() - radius;
+			}
+
+			inline dual3 distance(const dual_vec3& p) const {
+				return sphere(p, center, radius);
+			}
+
+			inline de_object operator()(vec3 p) const {
+				return de_object(distance(p), color);
+			}
+		};
+
+
+		// Object <A> moved by <offset>
+		template<typename A>
+		struct translate_node {
+
+			A a;
+			vec3 offset;
+
+			inline real distance(vec3 p) const {
+				return a.distance(p - offset);
+			}
+
+			inline dual3 distance(const dual_vec3& p) const {
+
+				dual_vec3 q;
+
+				for (unsigned int k = 0; k < 3; ++k)
+					q[k] = p.get(k) - offset.get(k);
+
+				return a.distance(q);
+			}
+
+			inline de_object operator()(vec3 p) const {
+				return a(p - offset);
+			}
+		};
+
+
+		// Union of objects <A> and <B>
+		template<typename A, typename B>
+		struct union_node {
+
+			A a;
+			B b;
+
+			inline real distance(vec3 p) const {
+				const real d_a = a.distance(p);
+				const real d_b = b.distance(p);
+				return d_a < d_b ? d_a : d_b;
+			}
+
+			inline dual3 distance(const dual_vec3& p) const {
+				return obj_union(a.distance(p), b.distance(p));
+			}
+
+			inline de_object operator()(vec3 p) const {
+				return obj_union(a(p), b(p));
+			}
+		};
+
+
+		// Smooth union of objects <A> and <B> over a distance <k>
+		template<typename A, typename B>
+		struct blend_node {
+
+			A a;
+			B b;
+			real k;
+
+			inline real distance(vec3 p) const {
+
+				const real d_a = a.distance(p);
+				const real d_b = b.distance(p);
+				const real h = theoretica::clamp(0.5 + 0.5 * (d_a - d_b) / k, 0.0, 1.0);
+
+				return theoretica::lerp(d_a, d_b, h) - k * h * (1.0 - h);
+			}
+
+			inline dual3 distance(const dual_vec3& p) const {
+				return obj_blend(a.distance(p), b.distance(p), k);
+			}
+
+			inline de_object operator()(vec3 p) const {
+				return obj_blend(a(p), b(p), k);
+			}
+		};
+
+
+		// Intersection of objects <A> and <B>
+		template<typename A, typename B>
+		struct intersection_node {
+
+			A a;
+			B b;
+
+			inline real distance(vec3 p) const {
+				const real d_a = a.distance(p);
+				const real d_b = b.distance(p);
+				return d_a > d_b ? d_a : d_b;
+			}
+
+			inline dual3 distance(const dual_vec3& p) const {
+				return obj_intersection(a.distance(p), b.distance(p));
+			}
+
+			inline de_object operator()(vec3 p) const {
+				return obj_intersection(a(p), b(p));
+			}
+		};
+
+
+		// Object <B> with <A> carved out of it
+		template<typename A, typename B>
+		struct difference_node {
+
+			A a;
+			B b;
+
+			inline real distance(vec3 p) const {
+				const real d_a = a.distance(p);
+				const real d_b = b.distance(p);
+				return -d_a > d_b ? -d_a : d_b;
+			}
+
+			inline dual3 distance(const dual_vec3& p) const {
+				return obj_difference(a.distance(p), b.distance(p));
+			}
+
+			// As obj_difference(), but with the distance of the carved object
+			// negated, so that it agrees with distance()
+			inline de_object operator()(vec3 p) const {
+
+				de_object obj_a = a(p);
+				const de_object obj_b = b(p);
+
+				if(-obj_a.distance > obj_b.distance) {
+					obj_a.distance = -obj_a.distance;
+					return obj_a;
+				}
+
+				return obj_b;
+			}
+		};
+
+
+		// Build a sphere node
+		inline sphere_node make_sphere(vec3 center, real radius, pixel color) {
+			sphere_node s;
+			s.center = center;
+			s.radius = radius;
+			s.color = color;
+			return s;
+		}
+
+
+		// Build a node moving <a> by <offset>
+		template<typename A>
+		inline translate_node<A> make_translate(const A& a, vec3 offset) {
+			translate_node<A> t;
+			t.a = a;
+			t.offset = offset;
+			return t;
+		}
+
+
+		// Build the union of <a> and <b>
+		template<typename A, typename B>
+		inline union_node<A, B> make_union(const A& a, const B& b) {
+			union_node<A, B> u;
+			u.a = a;
+			u.b = b;
+			return u;
+		}
+
+
+		// Build the smooth union of <a> and <b> over a distance <k>
+		template<typename A, typename B>
+		inline blend_node<A, B> make_blend(const A& a, const B& b, real k) {
+			blend_node<A, B> u;
+			u.a = a;
+			u.b = b;
+			u.k = k;
+			return u;
+		}
+
+
+		// Build the intersection of <a> and <b>
+		template<typename A, typename B>
+		inline intersection_node<A, B> make_intersection(const A& a, const B& b) {
+			intersection_node<A, B> u;
+			u.a = a;
+			u.b = b;
+			return u;
+		}
+
+
+		// Build the difference of <b> and <a>
+		template<typename A, typename B>
+		inline difference_node<A, B> make_difference(const A& a, const B& b) {
+			difference_node<A, B> u;
+			u.a = a;
+			u.b = b;
+			return u;
+		}
+
+
+		// Wrap a compile-time scene as a runtime SDF
+		template<typename Scene>
+		inline SDF to_SDF(const Scene& scene) {
+			return [scene](vec3 p) { return scene(p); };
+		}
+
+	}
+
+}
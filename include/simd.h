@@ -0,0 +1,260 @@
+#pragma once
+
+// Portable fixed-width SIMD lanes
+//
+// Lanes are plain arrays operated on by short loops without
+// cross-lane dependencies, which GCC and Clang auto-vectorize at -O3.
+// Lanes use double precision, as long double has no vector registers.
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+
+#ifndef GIULIA_SIMD_WIDTH
+#define GIULIA_SIMD_WIDTH 4
+#endif
+
+
+namespace giulia {
+
+
+	// A per-lane boolean mask
+	template<unsigned int N>
+	struct simd_mask {
+
+		bool m[N];
+
+		simd_mask() {}
+
+		explicit simd_mask(bool b) {
+			for (unsigned int l = 0; l < N; ++l)
+				m[l] = b;
+		}
+
+		inline bool& operator[](unsigned int l) {
+			return m[l];
+		}
+
+		inline bool operator[](unsigned int l) const {
+			return m[l];
+		}
+
+		inline simd_mask operator&(const simd_mask& other) const {
+			simd_mask r;
+			for (unsigned int l = 0; l < N; ++l)
+				r.m[l] = m[l] && other.m[l];
+			return r;
+		}
+
+		inline simd_mask operator|(const simd_mask& other) const {
+			simd_mask r;
+			for (unsigned int l = 0; l < N; ++l)
+				r.m[l] = m[l] || other.m[l];
+			return r;
+		}
+
+		inline simd_mask operator!() const {
+			simd_mask r;
+			for (unsigned int l = 0; l < N; ++l)
+				r.m[l] = !m[l];
+			return r;
+		}
+
+		// Whether any lane is set
+		inline bool any() const {
+			bool r = false;
+			for (unsigned int l = 0; l < N; ++l)
+				r = r || m[l];
+			return r;
+		}
+
+		// Whether all lanes are set
+		inline bool all() const {
+			bool r = true;
+			for (unsigned int l = 0; l < N; ++l)
+				r = r && m[l];
+			return r;
+		}
+	};
+
+
+	// A pack of N double precision lanes
+	template<unsigned int N>
+	struct simd_vec {
+
+		static constexpr unsigned int width = N;
+
+		alignas(sizeof(double) * N) double v[N];
+
+		simd_vec() {}
+
+		// Broadcast a scalar to all lanes
+		simd_vec(double x) {
+			for (unsigned int l = 0; l < N; ++l)
+				v[l] = x;
+		}
+
+		// Load N contiguous values
+		inline static simd_vec load(const double* p) {
+			simd_vec r;
+			for (unsigned int l = 0; l < N; ++l)
+				r.v[l] = p[l];
+			return r;
+		}
+
+		// Store N contiguous values
+		inline void store(double* p) const {
+			for (unsigned int l = 0; l < N; ++l)
+				p[l] = v[l];
+		}
+
+		inline double& operator[](unsigned int l) {
+			return v[l];
+		}
+
+		inline double operator[](unsigned int l) const {
+			return v[l];
+		}
+
+		inline simd_vec operator-() const {
+			simd_vec r;
+			for (unsigned int l = 0; l < N; ++l)
+				r.v[l] = -v[l];
+			return r;
+		}
+
+#define GIULIA_SIMD_OP(op) \
+		inline simd_vec operator op(const simd_vec& other) const { \
+			simd_vec r; \
+			for (unsigned int l = 0; l < N; ++l) \
+				r.v[l] = v[l] op other.v[l]; \
+			return r; \
+		} \
+		inline simd_vec& operator op##=(const simd_vec& other) { \
+			for (unsigned int l = 0; l < N; ++l) \
+				v[l] = v[l] op other.v[l]; \
+			return *this; \
+		} \
+		inline friend simd_vec operator op(double a, const simd_vec& b) { \
+			return simd_vec(a) op b; \
+		}
+
+		GIULIA_SIMD_OP(+)
+		GIULIA_SIMD_OP(-)
+		GIULIA_SIMD_OP(*)
+		GIULIA_SIMD_OP(/)
+
+#undef GIULIA_SIMD_OP
+
+#define GIULIA_SIMD_CMP(op) \
+		inline simd_mask<N> operator op(const simd_vec& other) const { \
+			simd_mask<N> r; \
+			for (unsigned int l = 0; l < N; ++l) \
+				r.m[l] = v[l] op other.v[l]; \
+			return r; \
+		}
+
+		GIULIA_SIMD_CMP(<)
+		GIULIA_SIMD_CMP(<=)
+		GIULIA_SIMD_CMP(>)
+		GIULIA_SIMD_CMP(>=)
+
+#undef GIULIA_SIMD_CMP
+	};
+
+
+	// Default lane type
+	using simd_real = simd_vec<GIULIA_SIMD_WIDTH>;
+
+	// Default mask type
+	using simd_bool = simd_mask<GIULIA_SIMD_WIDTH>;
+
+
+	// Lane-wise math functions
+	namespace simd {
+
+		// Per-lane selection of <a> where <m> is set and <b> elsewhere
+		template<unsigned int N>
+		inline simd_vec<N> select(const simd_mask<N>& m, const simd_vec<N>& a, const simd_vec<N>& b) {
+			simd_vec<N> r;
+			for (unsigned int l = 0; l < N; ++l)
+				r.v[l] = m.m[l] ? a.v[l] : b.v[l];
+			return r;
+		}
+
+
+		template<unsigned int N>
+		inline simd_vec<N> min(const simd_vec<N>& a, const simd_vec<N>& b) {
+			simd_vec<N> r;
+			for (unsigned int l = 0; l < N; ++l)
+				r.v[l] = a.v[l] < b.v[l] ? a.v[l] : b.v[l];
+			return r;
+		}
+
+
+		template<unsigned int N>
+		inline simd_vec<N> max(const simd_vec<N>& a, const simd_vec<N>& b) {
+			simd_vec<N> r;
+			for (unsigned int l = 0; l < N; ++l)
+				r.v[l] = a.v[l] > b.v[l] ? a.v[l] : b.v[l];
+			return r;
+		}
+
+
+		template<unsigned int N>
+		inline simd_vec<N> abs(const simd_vec<N>& a) {
+			simd_vec<N> r;
+			for (unsigned int l = 0; l < N; ++l)
+				r.v[l] = std::fabs(a.v[l]);
+			return r;
+		}
+
+
+		template<unsigned int N>
+		inline simd_vec<N> sqrt(const simd_vec<N>& a) {
+			simd_vec<N> r;
+			for (unsigned int l = 0; l < N; ++l)
+				r.v[l] = std::sqrt(a.v[l]);
+			return r;
+		}
+
+
+		// Natural logarithm of positive normal lanes, with a relative error
+		// below 1E-10. The exponent is extracted from the bits of each lane
+		// and the logarithm of the mantissa, reduced to [sqrt(2)/2, sqrt(2)],
+		// is evaluated as 2 atanh((m - 1) / (m + 1)) by a short odd series.
+		template<unsigned int N>
+		inline simd_vec<N> log(const simd_vec<N>& a) {
+
+			simd_vec<N> r;
+
+			for (unsigned int l = 0; l < N; ++l) {
+
+				uint64_t bits;
+				std::memcpy(&bits, &a.v[l], sizeof(double));
+
+				double e = (double) ((int64_t) ((bits >> 52) & 0x7FF) - 1023);
+				bits = (bits & 0x000FFFFFFFFFFFFFULL) | 0x3FF0000000000000ULL;
+
+				double m;
+				std::memcpy(&m, &bits, sizeof(double));
+
+				const bool high = m > 1.4142135623730951;
+				m = high ? m * 0.5 : m;
+				e = high ? e + 1 : e;
+
+				const double f = (m - 1) / (m + 1);
+				const double s = f * f;
+				const double p = 1 + s * (1.0 / 3 + s * (1.0 / 5 + s * (1.0 / 7
+					+ s * (1.0 / 9 + s * (1.0 / 11)))));
+
+				r.v[l] = e * 0.6931471805599453 + 2 * f * p;
+			}
+
+			return r;
+		}
+
+	}
+
+}
@@ -0,0 +1,306 @@
+
+///
+/// @file complex_dual.h Complex dual number class
+///
+
+#ifndef THEORETICA_COMPLEX_DUAL_H
+#define THEORETICA_COMPLEX_DUAL_H
+
+#ifndef THEORETICA_NO_PRINT
+#include <sstream>
+#include <ostream>
+#endif
+
+#include "../core/error.h"
+#include "../core/constants.h"
+#include "../complex/complex.h"
+
+
+namespace theoretica {
+
+
+	///
+	/// @class complex_dual
+	/// Dual number class with complex parts.
+	/// Implemented as \f$a + b \epsilon\f$ where \f$a\f$ and \f$b\f$
+	/// are complex numbers and \f$\epsilon\f$ is such that \f$\epsilon^2 = 0\f$,
+	/// so that holomorphic functions carry their complex derivative
+	/// in the dual part.
+	///
+	class complex_dual {
+		public:
+
+			complex a; // Real part
+			complex b; // "Dual" part
+
+			/// Default constructor, initialize with null values
+			complex_dual() : a(0), b(0) {}
+
+			/// Initialize from two complex numbers
+			complex_dual(complex real_part, complex dual_part)
+				: a(real_part), b(dual_part) {}
+
+			/// Initialize from a complex number
+			complex_dual(complex real_part)
+				: a(real_part), b(0) {}
+
+			/// Initialize from a real number
+			complex_dual(real real_part)
+				: a(real_part), b(0) {}
+
+			~complex_dual() = default;
+
+			/// Initialize a complex dual number from a complex number
+			inline complex_dual& operator=(complex z) {
+				a = z;
+				b = complex(0);
+				return *this;
+			}
+
+			/// Initialize a complex dual number from a real number
+			inline complex_dual& operator=(real x) {
+				a = complex(x);
+				b = complex(0);
+				return *this;
+			}
+
+			/// Return real part
+			inline complex Re() const {
+				return a;
+			}
+
+			/// Return dual part
+			inline complex Dual() const {
+				return b;
+			}
+
+			/// Get the dual conjugate
+			inline complex_dual conjugate() const {
+				return complex_dual(a, -b);
+			}
+
+			/// Get the inverse of a complex dual number
+			inline complex_dual inverse() const {
+
+				if(a.square_modulus() == 0) {
+					TH_MATH_ERROR("complex_dual::inverse", 0, DIV_BY_ZERO);
+					return complex_dual(complex(nan(), nan()), complex(nan(), nan()));
+				}
+
+				const complex inv_a = complex(1) / a;
+				return complex_dual(inv_a, -b * inv_a * inv_a);
+			}
+
+			/// Identity (for consistency)
+			inline complex_dual operator+() const {
+				return complex_dual(a, b);
+			}
+
+			/// Sum two complex dual numbers
+			inline complex_dual operator+(const complex_dual& other) const {
+				return complex_dual(a + other.a, b + other.b);
+			}
+
+			/// Sum a complex number to a complex dual number
+			inline complex_dual operator+(const complex& z) const {
+				return complex_dual(a + z, b);
+			}
+
+			/// Sum a real number to a complex dual number
+			inline complex_dual operator+(real r) const {
+				return complex_dual(a + r, b);
+			}
+
+			/// Get the opposite of a complex dual number
+			inline complex_dual operator-() const {
+				return complex_dual(-a, -b);
+			}
+
+			/// Subtract two complex dual numbers
+			inline complex_dual operator-(const complex_dual& other) const {
+				return complex_dual(a - other.a, b - other.b);
+			}
+
+			/// Subtract a complex number from a complex dual number
+			inline complex_dual operator-(const complex& z) const {
+				return complex_dual(a - z, b);
+			}
+
+			/// Subtract a real number from a complex dual number
+			inline complex_dual operator-(real r) const {
+				return complex_dual(a - r, b);
+			}
+
+			/// Multiply two complex dual numbers
+			inline complex_dual operator*(const complex_dual& other) const {
+				return complex_dual(a * other.a, a * other.b + b * other.a);
+			}
+
+			/// Multiply a complex dual number by a complex number
+			inline complex_dual operator*(const complex& z) const {
+				return complex_dual(a * z, b * z);
+			}
+
+			/// Multiply a complex dual number by a real number
+			inline complex_dual operator*(real r) const {
+				return complex_dual(a * r, b * r);
+			}
+
+			/// Complex dual division
+			inline complex_dual operator/(const complex_dual& other) const {
+
+				const complex inv = complex(1) / other.a;
+				return complex_dual(a * inv, (b * other.a - a * other.b) * inv * inv);
+			}
+
+			/// Divide a complex dual number by a complex number
+			inline complex_dual operator/(const complex& z) const {
+
+				const complex inv = complex(1) / z;
+				return complex_dual(a * inv, b * inv);
+			}
+
+			/// Divide a complex dual number by a real number
+			inline complex_dual operator/(real r) const {
+				return complex_dual(a / r, b / r);
+			}
+
+
+			/// Sum a complex dual number to this one
+			inline complex_dual& operator+=(const complex_dual& other) {
+
+				a += other.a;
+				b += other.b;
+				return *this;
+			}
+
+			/// Sum a real number to this complex dual number
+			inline complex_dual& operator+=(real r) {
+
+				a += r;
+				return *this;
+			}
+
+			/// Subtract a complex dual number from this one
+			inline complex_dual& operator-=(const complex_dual& other) {
+
+				a -= other.a;
+				b -= other.b;
+				return *this;
+			}
+
+			/// Subtract a real number from this complex dual number
+			inline complex_dual& operator-=(real r) {
+
+				a -= r;
+				return *this;
+			}
+
+			/// Multiply this complex dual number by another one
+			inline complex_dual& operator*=(const complex_dual& other) {
+
+				b = (a * other.b) + (b * other.a);
+				a = (a * other.a);
+				return *this;
+			}
+
+			/// Multiply this complex dual number by a real number
+			inline complex_dual& operator*=(real r) {
+
+				a *= r;
+				b *= r;
+				return *this;
+			}
+
+			/// Divide this complex dual number by another one
+			inline complex_dual& operator/=(const complex_dual& other) {
+				return (*this = *this / other);
+			}
+
+			/// Divide this complex dual number by a real number
+			inline complex_dual& operator/=(real r) {
+
+				if(r == 0) {
+					TH_MATH_ERROR("complex_dual::operator/=", 0, DIV_BY_ZERO);
+					a = complex(nan(), nan());
+					b = complex(nan(), nan());
+					return *this;
+				}
+
+				a /= r;
+				b /= r;
+
+				return *this;
+			}
+
+
+			/// Check whether two complex dual numbers have the same
+			/// real and dual parts
+			inline bool operator==(const complex_dual& other) {
+				return (a == other.a) && (b == other.b);
+			}
+
+
+			// Friend operators to enable equations of the form
+			// (real) op. (complex_dual) and (complex) op. (complex_dual)
+
+			inline friend complex_dual operator+(real r, const complex_dual& d) {
+				return d + r;
+			}
+
+			inline friend complex_dual operator-(real r, const complex_dual& d) {
+				return -d + r;
+			}
+
+			inline friend complex_dual operator*(real r, const complex_dual& d) {
+				return d * r;
+			}
+
+			inline friend complex_dual operator/(real r, const complex_dual& d) {
+				return complex_dual(r) / d;
+			}
+
+			inline friend complex_dual operator+(const complex& z, const complex_dual& d) {
+				return d + z;
+			}
+
+			inline friend complex_dual operator-(const complex& z, const complex_dual& d) {
+				return -d + z;
+			}
+
+			inline friend complex_dual operator*(const complex& z, const complex_dual& d) {
+				return d * z;
+			}
+
+			inline friend complex_dual operator/(const complex& z, const complex_dual& d) {
+				return complex_dual(z) / d;
+			}
+
+
+#ifndef THEORETICA_NO_PRINT
+
+			/// Convert the complex dual number to string representation
+			/// @param epsilon The character to use to represent epsilon
+			inline std::string to_string(const std::string& epsilon = "e") const {
+
+				std::stringstream res;
+				res << "(" << a << ") + (" << b << ")" << epsilon;
+
+				return res.str();
+			}
+
+
+			/// Stream the complex dual number in string representation
+			/// to an output stream (std::ostream)
+			inline friend std::ostream& operator<<(std::ostream& out, const complex_dual& obj) {
+				return out << obj.to_string();
+			}
+
+#endif
+
+	};
+
+}
+
+
+#endif
@@ -0,0 +1,138 @@
+
+///
+/// @file complex_dual_functions.h Functions defined on complex dual numbers
+/// for automatic differentiation of holomorphic functions.
+///
+/// The result of a holomorphic function evaluated on a complex
+/// dual number has a real part equal to the function evaluated
+/// for the given argument and a "dual" part equal to the
+/// complex derivative evaluated for the given argument.
+
+
+#ifndef THEORETICA_COMPLEX_DUAL_FUNCTIONS_H
+#define THEORETICA_COMPLEX_DUAL_FUNCTIONS_H
+
+#include "./complex_dual.h"
+#include "../complex/complex_analysis.h"
+
+
+namespace theoretica {
+
+
+	/// Return the square of a complex dual number
+	inline complex_dual square(complex_dual z) {
+		return complex_dual(square(z.Re()), 2 * z.Re() * z.Dual());
+	}
+
+
+	/// Return the cube of a complex dual number
+	inline complex_dual cube(complex_dual z) {
+
+		const complex z2 = square(z.Re());
+		return complex_dual(z2 * z.Re(), 3 * z2 * z.Dual());
+	}
+
+
+	/// Compute the n-th power of a complex dual number
+	inline complex_dual pow(complex_dual z, int n) {
+
+		if(n == 0)
+			return complex_dual(1);
+
+		if(n < 0)
+			return complex_dual(1) / pow(z, -n);
+
+		// Power by squaring of the real part
+		complex pow_n_1_z = complex(1);
+		complex base = z.Re();
+
+		for (int k = n - 1; k > 0; k >>= 1) {
+
+			if(k & 1)
+				pow_n_1_z = pow_n_1_z * base;
+
+			base = base * base;
+		}
+
+		return complex_dual(pow_n_1_z * z.Re(), pow_n_1_z * n * z.Dual());
+	}
+
+
+	/// Compute the square root of a complex dual number
+	inline complex_dual sqrt(complex_dual z) {
+
+		const complex sqrt_z = sqrt(z.Re());
+
+		if(sqrt_z.square_modulus() == 0) {
+			TH_MATH_ERROR("sqrt(complex_dual)", 0, DIV_BY_ZERO);
+			return complex_dual(complex(nan(), nan()), complex(nan(), nan()));
+		}
+
+		return complex_dual(sqrt_z, z.Dual() / (sqrt_z * 2));
+	}
+
+
+	/// Compute the sine of a complex dual number
+	inline complex_dual sin(complex_dual z) {
+
+		// Share the exponentials between the sine and the cosine
+		const complex t = z.Re() * complex(0, 1);
+		const complex e_t = exp(t);
+		const complex e_mt = complex(1) / e_t;
+
+		return complex_dual(
+			(e_t - e_mt) / complex(0, 2),
+			(e_t + e_mt) / 2.0 * z.Dual());
+	}
+
+
+	/// Compute the cosine of a complex dual number
+	inline complex_dual cos(complex_dual z) {
+
+		const complex t = z.Re() * complex(0, 1);
+		const complex e_t = exp(t);
+		const complex e_mt = complex(1) / e_t;
+
+		return complex_dual(
+			(e_t + e_mt) / 2.0,
+			-(e_t - e_mt) / complex(0, 2) * z.Dual());
+	}
+
+
+	/// Compute the tangent of a complex dual number
+	inline complex_dual tan(complex_dual z) {
+
+		const complex cos_z = cos(z.Re());
+
+		if(cos_z.square_modulus() == 0) {
+			TH_MATH_ERROR("tan(complex_dual)", 0, DIV_BY_ZERO);
+			return complex_dual(complex(nan(), nan()), complex(nan(), nan()));
+		}
+
+		return complex_dual(sin(z.Re()) / cos_z, z.Dual() / square(cos_z));
+	}
+
+
+	/// Compute the exponential of a complex dual number
+	inline complex_dual exp(complex_dual z) {
+
+		const complex exp_z = exp(z.Re());
+		return complex_dual(exp_z, exp_z * z.Dual());
+	}
+
+
+	/// Compute the principal natural logarithm of a complex dual number
+	inline complex_dual ln(complex_dual z) {
+
+		if(z.Re().square_modulus() == 0) {
+			TH_MATH_ERROR("ln(complex_dual)", 0, OUT_OF_DOMAIN);
+			return complex_dual(complex(nan(), nan()), complex(nan(), nan()));
+		}
+
+		return complex_dual(ln(z.Re()), z.Dual() / z.Re());
+	}
+
+}
+
+
+#endif
@@ -0,0 +1,114 @@
+
+///
+/// @file complex_interval.h Rectangular intervals of complex numbers
+///
+
+#ifndef THEORETICA_COMPLEX_INTERVAL_H
+#define THEORETICA_COMPLEX_INTERVAL_H
+
+#include "./interval.h"
+#include "../complex/complex.h"
+
+
+namespace theoretica {
+
+
+	///
+	/// @class complex_interval
+	/// Rectangle of the complex plane \f$[a] + i [b]\f$
+	/// where \f$[a]\f$ and \f$[b]\f$ are real intervals,
+	/// enclosing the results of complex operations over
+	/// all the points of its operands.
+	///
+	class complex_interval {
+		public:
+
+			interval a; // Real part
+			interval b; // Imaginary part
+
+			/// Default constructor, initialize to zero
+			complex_interval() : a(0), b(0) {}
+
+			/// Initialize from two intervals
+			complex_interval(interval real_part, interval imag_part)
+				: a(real_part), b(imag_part) {}
+
+			/// Initialize to the rectangle containing only <z>
+			complex_interval(complex z)
+				: a(z.Re()), b(z.Im()) {}
+
+			~complex_interval() = default;
+
+			/// Return real part
+			inline interval Re() const {
+				return a;
+			}
+
+			/// Return imaginary part
+			inline interval Im() const {
+				return b;
+			}
+
+			/// Get the complex conjugate
+			inline complex_interval conjugate() const {
+				return complex_interval(a, -b);
+			}
+
+			/// Bound the square modulus over the rectangle
+			inline interval square_modulus() const {
+				return square(a) + square(b);
+			}
+
+			/// Sum two complex intervals
+			inline complex_interval operator+(const complex_interval& other) const {
+				return complex_interval(a + other.a, b + other.b);
+			}
+
+			/// Sum a complex number to a complex interval
+			inline complex_interval operator+(const complex& z) const {
+				return complex_interval(a + z.Re(), b + z.Im());
+			}
+
+			/// Get the opposite of a complex interval
+			inline complex_interval operator-() const {
+				return complex_interval(-a, -b);
+			}
+
+			/// Subtract two complex intervals
+			inline complex_interval operator-(const complex_interval& other) const {
+				return complex_interval(a - other.a, b - other.b);
+			}
+
+			/// Subtract a complex number from a complex interval
+			inline complex_interval operator-(const complex& z) const {
+				return complex_interval(a - z.Re(), b - z.Im());
+			}
+
+			/// Multiply two complex intervals
+			inline complex_interval operator*(const complex_interval& other) const {
+				return complex_interval(
+					a * other.a - b * other.b,
+					a * other.b + b * other.a);
+			}
+
+			/// Multiply a complex interval by a real number
+			inline complex_interval operator*(real r) const {
+				return complex_interval(a * r, b * r);
+			}
+
+	};
+
+
+	/// Return the square of a complex interval,
+	/// squaring the real and imaginary parts separately
+	/// for a tighter bound than the product by itself
+	inline complex_interval square(const complex_interval& z) {
+		return complex_interval(
+			square(z.a) - square(z.b),
+			z.a * z.b * 2);
+	}
+
+}
+
+
+#endif
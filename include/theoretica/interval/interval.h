@@ -0,0 +1,327 @@
+
+///
+/// @file interval.h Interval arithmetic
+///
+
+#ifndef THEORETICA_INTERVAL_H
+#define THEORETICA_INTERVAL_H
+
+#ifndef THEORETICA_NO_PRINT
+#include <sstream>
+#include <ostream>
+#endif
+
+#include "../core/error.h"
+#include "../core/constants.h"
+#include "../core/real_analysis.h"
+#include "../algebra/vec.h"
+
+
+namespace theoretica {
+
+
+	///
+	/// @class interval
+	/// Closed interval of real numbers \f$[lo, hi]\f$.
+	/// The result of an arithmetic operation on intervals
+	/// encloses the results of the operation on every pair of
+	/// their elements, so that a function evaluated on intervals
+	/// bounds its range over a whole region at once.
+	/// Bounds are not rounded outwards, so they may be off
+	/// by a few ulps from a rigorous enclosure.
+	///
+	class interval {
+		public:
+
+			real lo; // Lower bound
+			real hi; // Upper bound
+
+			/// Default constructor, initialize to [0, 0]
+			interval() : lo(0), hi(0) {}
+
+			/// Initialize to the degenerate interval [x, x]
+			interval(real x) : lo(x), hi(x) {}
+
+			/// Initialize from two bounds, in any order
+			interval(real a, real b)
+				: lo(a < b ? a : b), hi(a < b ? b : a) {}
+
+			~interval() = default;
+
+			/// Initialize to the degenerate interval [x, x]
+			inline interval& operator=(real x) {
+				lo = x;
+				hi = x;
+				return *this;
+			}
+
+			/// Get the width of the interval
+			inline real width() const {
+				return hi - lo;
+			}
+
+			/// Get the midpoint of the interval
+			inline real midpoint() const {
+				return (lo + hi) * 0.5;
+			}
+
+			/// Whether the interval contains <x>
+			inline bool contains(real x) const {
+				return lo <= x && x <= hi;
+			}
+
+			/// Identity (for consistency)
+			inline interval operator+() const {
+				return *this;
+			}
+
+			/// Sum two intervals
+			inline interval operator+(const interval& other) const {
+				return interval(lo + other.lo, hi + other.hi);
+			}
+
+			/// Sum a real number to an interval
+			inline interval operator+(real r) const {
+				return interval(lo + r, hi + r);
+			}
+
+			/// Get the opposite of an interval
+			inline interval operator-() const {
+				return interval(-hi, -lo);
+			}
+
+			/// Subtract two intervals
+			inline interval operator-(const interval& other) const {
+				return interval(lo - other.hi, hi - other.lo);
+			}
+
+			/// Subtract a real number from an interval
+			inline interval operator-(real r) const {
+				return interval(lo - r, hi - r);
+			}
+
+			/// Multiply two intervals
+			inline interval operator*(const interval& other) const {
+
+				const real p1 = lo * other.lo;
+				const real p2 = lo * other.hi;
+				const real p3 = hi * other.lo;
+				const real p4 = hi * other.hi;
+
+				interval res;
+				res.lo = min(min(p1, p2), min(p3, p4));
+				res.hi = max(max(p1, p2), max(p3, p4));
+				return res;
+			}
+
+			/// Multiply an interval by a real number
+			inline interval operator*(real r) const {
+				return interval(lo * r, hi * r);
+			}
+
+			/// Divide two intervals, giving the whole real line
+			/// when the divisor contains zero
+			inline interval operator/(const interval& other) const {
+
+				if(other.contains(0)) {
+					interval res;
+					res.lo = -inf();
+					res.hi = inf();
+					return res;
+				}
+
+				return (*this) * interval(1 / other.hi, 1 / other.lo);
+			}
+
+			/// Divide an interval by a real number
+			inline interval operator/(real r) const {
+
+				if(r == 0) {
+					TH_MATH_ERROR("interval::operator/", r, DIV_BY_ZERO);
+					return interval(nan());
+				}
+
+				return interval(lo / r, hi / r);
+			}
+
+			/// Sum another interval to this one
+			inline interval& operator+=(const interval& other) {
+				return (*this = *this + other);
+			}
+
+			/// Sum a real number to this interval
+			inline interval& operator+=(real r) {
+				return (*this = *this + r);
+			}
+
+			/// Subtract another interval from this one
+			inline interval& operator-=(const interval& other) {
+				return (*this = *this - other);
+			}
+
+			/// Subtract a real number from this interval
+			inline interval& operator-=(real r) {
+				return (*this = *this - r);
+			}
+
+			/// Multiply this interval by another one
+			inline interval& operator*=(const interval& other) {
+				return (*this = *this * other);
+			}
+
+			/// Multiply this interval by a real number
+			inline interval& operator*=(real r) {
+				return (*this = *this * r);
+			}
+
+			/// Divide this interval by another one
+			inline interval& operator/=(const interval& other) {
+				return (*this = *this / other);
+			}
+
+			/// Divide this interval by a real number
+			inline interval& operator/=(real r) {
+				return (*this = *this / r);
+			}
+
+			/// Check whether two intervals are equal
+			inline bool operator==(const interval& other) const {
+				return lo == other.lo && hi == other.hi;
+			}
+
+			/// Check whether two intervals are not equal
+			inline bool operator!=(const interval& other) const {
+				return !(*this == other);
+			}
+
+			/// Sum a real number and an interval
+			friend inline interval operator+(real r, const interval& i) {
+				return i + r;
+			}
+
+			/// Subtract an interval from a real number
+			friend inline interval operator-(real r, const interval& i) {
+				return interval(r - i.hi, r - i.lo);
+			}
+
+			/// Multiply a real number and an interval
+			friend inline interval operator*(real r, const interval& i) {
+				return i * r;
+			}
+
+			/// Divide a real number by an interval
+			friend inline interval operator/(real r, const interval& i) {
+				return interval(r) / i;
+			}
+
+
+#ifndef THEORETICA_NO_PRINT
+
+			/// Convert the interval to string representation
+			inline std::string to_string() const {
+
+				std::stringstream res;
+				res << "[" << lo << ", " << hi << "]";
+				return res.str();
+			}
+
+
+			/// Convert the interval to string representation
+			inline operator std::string() {
+				return to_string();
+			}
+
+
+			/// Stream the interval in string representation
+			/// to an output stream (std::ostream)
+			inline friend std::ostream& operator<<(std::ostream& out, const interval& obj) {
+				return out << obj.to_string();
+			}
+
+#endif
+
+	};
+
+
+	/// Return the square of an interval, which is tighter
+	/// than the product of the interval by itself
+	inline interval square(interval x) {
+
+		const real a = x.lo * x.lo;
+		const real b = x.hi * x.hi;
+
+		if(x.contains(0))
+			return interval(0, max(a, b));
+
+		return interval(a, b);
+	}
+
+
+	/// Compute the square root of an interval,
+	/// clipping the negative part of the interval
+	inline interval sqrt(interval x) {
+
+		if(x.hi < 0) {
+			TH_MATH_ERROR("sqrt(interval)", x.hi, OUT_OF_DOMAIN);
+			return interval(nan());
+		}
+
+		interval res;
+		res.lo = x.lo > 0 ? sqrt(x.lo) : 0;
+		res.hi = sqrt(x.hi);
+		return res;
+	}
+
+
+	/// Compute the absolute value of an interval
+	inline interval abs(interval x) {
+
+		if(x.contains(0))
+			return interval(0, max(-x.lo, x.hi));
+
+		return interval(abs(x.lo), abs(x.hi));
+	}
+
+
+	/// Compute the minimum of two intervals
+	inline interval min(interval x, interval y) {
+		return interval(min(x.lo, y.lo), min(x.hi, y.hi));
+	}
+
+
+	/// Compute the maximum of two intervals
+	inline interval max(interval x, interval y) {
+		return interval(max(x.lo, y.lo), max(x.hi, y.hi));
+	}
+
+
+	/// Smallest interval containing both intervals
+	inline interval hull(interval x, interval y) {
+		return interval(min(x.lo, y.lo), max(x.hi, y.hi));
+	}
+
+
+	/// Identity, so that vectors of intervals may be
+	/// handled by the same routines as real vectors
+	inline interval conjugate(interval x) {
+		return x;
+	}
+
+
+	/// Compute the Euclidean norm of a vector of intervals,
+	/// squaring each component separately for a tight bound
+	template<unsigned int N>
+	inline interval length(const vec<N, interval>& v) {
+
+		interval sum = 0;
+
+		for (unsigned int i = 0; i < N; ++i)
+			sum += square(v.get(i));
+
+		return sqrt(sum);
+	}
+
+}
+
+
+#endif
@@ -72,8 +72,14 @@
 #include "./autodiff/multidual_functions.h"
 #include "./autodiff/dual2.h"
 #include "./autodiff/dual2_functions.h"
+#include "./autodiff/complex_dual.h"
+#include "./autodiff/complex_dual_functions.h"
 #include "./autodiff/autodiff.h"
 
+// Interval arithmetic
+#include "./interval/interval.h"
+#include "./interval/complex_interval.h"
+
 // Pseudorandom number generation
 #include "./pseudorandom/pseudorandom.h"
 #include "./pseudorandom/prng.h"
@@ -0,0 +1,137 @@
+#include "atlas.h"
+#include "fractals.h"
+
+
+using namespace giulia;
+
+
+namespace {
+
+	// Side of the grid of probe samples of each thumbnail
+	const unsigned int probe_side = 8;
+
+}
+
+
+giulia::julia_atlas::julia_atlas(
+	unsigned int k, unsigned int thumb,
+	real_t c_x_min, real_t c_y_min, real_t c_x_max, real_t c_y_max, real_t radius)
+	: k(k), thumb(thumb), c_x_min(c_x_min), c_y_min(c_y_min),
+	c_x_max(c_x_max), c_y_max(c_y_max), radius(radius) {
+
+	budgets.assign(k * k, 0);
+}
+
+
+void giulia::julia_atlas::get_parameter(unsigned int i, unsigned int j, real_t& c_x, real_t& c_y) const {
+
+	// The first row holds the highest imaginary parts
+	c_x = c_x_min + (i + 0.5) / k * (c_x_max - c_x_min);
+	c_y = c_y_max - (j + 0.5) / k * (c_y_max - c_y_min);
+}
+
+
+unsigned int giulia::julia_atlas::get_budget(unsigned int i, unsigned int j) const {
+	return budgets[j * k + i];
+}
+
+
+unsigned int giulia::julia_atlas::get_size() const {
+	return k * thumb;
+}
+
+
+void giulia::julia_atlas::render(image& img, unsigned int min_iter, unsigned int max_iter) {
+
+	const unsigned int size = get_size();
+
+	if(img.get_width() != size || img.get_height() != size || !k || !thumb)
+		return;
+
+	// Probe every thumbnail for its iteration budget
+#ifdef GIULIA_USE_OPENMP
+#pragma omp parallel for schedule(dynamic, 1)
+#endif
+	for (int t = 0; t < (int) (k * k); ++t) {
+
+		real_t c_x, c_y;
+		get_parameter(t % k, t / k, c_x, c_y);
+
+		unsigned int budget = min_iter;
+
+		while(budget < max_iter) {
+
+			unsigned int late = 0;
+			unsigned int capped = 0;
+
+			for (unsigned int p = 0; p < probe_side * probe_side; ++p) {
+
+				const real_t x = radius * (2 * ((p % probe_side) + 0.5) / probe_side - 1);
+				const real_t y = radius * (2 * ((p / probe_side) + 0.5) / probe_side - 1);
+				const real_t iter = sample_julia(x, y, c_x, c_y, budget).iter;
+
+				late += (iter >= budget / 2 && iter < budget);
+				capped += !(iter < budget);
+			}
+
+			// Pixels at the limit are unlikely to escape
+			if(!capped || late <= 1)
+				break;
+
+			budget = (2 * budget < max_iter) ? 2 * budget : max_iter;
+		}
+
+		budgets[t] = budget;
+	}
+
+	// Draw all the thumbnails as a single job over the pixels of the atlas
+#ifdef GIULIA_USE_OPENMP
+#pragma omp parallel for schedule(dynamic, 256)
+#endif
+	for (int p = 0; p < (int) (size * size); ++p) {
+
+		const unsigned int px = p % size;
+		const unsigned int py = p / size;
+		const unsigned int t = (py / thumb) * k + (px / thumb);
+
+		real_t c_x, c_y;
+		get_parameter(px / thumb, py / thumb, c_x, c_y);
+
+		// Local coordinates within the thumbnail, with y pointing up
+		const real_t x = radius * (2 * ((px % thumb) + 0.5) / thumb - 1);
+		const real_t y = radius * (1 - 2 * ((py % thumb) + 0.5) / thumb);
+
+		const unsigned int budget = budgets[t];
+		img[p] = shade_gray(sample_julia(x, y, c_x, c_y, budget), budget, 0.04 * budget);
+	}
+}
+
+
+void giulia::julia_atlas::draw_index(image& img) const {
+
+	const unsigned int w = img.get_width();
+	const unsigned int h = img.get_height();
+
+	if(!k)
+		return;
+
+#ifdef GIULIA_USE_OPENMP
+#pragma omp parallel for schedule(dynamic, 256)
+#endif
+	for (int p = 0; p < (int) (w * h); ++p) {
+
+		const unsigned int px = p % w;
+		const unsigned int py = p / w;
+
+		// Outline the cells of the thumbnails
+		if((px * k) % w < k || (py * k) % h < k) {
+			img[p] = pixel(200, 30, 30);
+			continue;
+		}
+
+		const real_t c_x = c_x_min + (px + 0.5) / w * (c_x_max - c_x_min);
+		const real_t c_y = c_y_max - (py + 0.5) / h * (c_y_max - c_y_min);
+
+		img[p] = draw_mandelbrot(c_x, c_y, 500);
+	}
+}
@@ -0,0 +1,335 @@
+#include "buddhabrot.h"
+
+#define THEORETICA_LONG_DOUBLE_PREC
+#include "theoretica/theoretica.h"
+
+#include <cmath>
+
+#ifdef GIULIA_USE_OPENMP
+#include <omp.h>
+#endif
+
+using namespace giulia;
+using namespace theoretica;
+namespace th = theoretica;
+
+
+namespace {
+
+
+	// Whether c lies in the main cardioid or in the period-2 bulb,
+	// where orbits never escape
+	inline bool in_main_bulbs(double c_a, double c_b) {
+
+		const double q = (c_a - 0.25) * (c_a - 0.25) + c_b * c_b;
+
+		if(q * (q + (c_a - 0.25)) <= 0.25 * c_b * c_b)
+			return true;
+
+		return (c_a + 1) * (c_a + 1) + c_b * c_b <= 0.0625;
+	}
+
+
+	// State of a sampling thread
+	struct buddhabrot_sampler {
+
+		PRNG g;
+
+		// Bins hit by the orbit of the current and proposed parameters
+		std::vector<uint32_t> current;
+		std::vector<uint32_t> proposal;
+
+		// Current parameter of the Metropolis chain and its escape time
+		double c_a {0};
+		double c_b {0};
+		unsigned int escape {0};
+		bool started {false};
+
+		buddhabrot_sampler(uint64_t seed) : g(PRNG::xoshiro(seed)) {}
+
+		inline double uniform(double a, double b) {
+			return a + (b - a) * ((g() >> 11) / 9007199254740992.0);
+		}
+	};
+
+}
+
+
+giulia::buddhabrot::buddhabrot(
+	unsigned int width, unsigned int height,
+	real_t center_x, real_t center_y, real_t scale)
+	: width(width), height(height), center_x(center_x), center_y(center_y), scale(scale) {}
+
+
+void giulia::buddhabrot::add_channel(unsigned int min_iter, unsigned int max_iter, pixel color) {
+
+	buddhabrot_channel ch;
+	ch.min_iter = min_iter;
+	ch.max_iter = max_iter;
+	ch.color = color;
+	channels.push_back(ch);
+
+	// Accumulated counts are discarded when the layout changes
+	std::vector<std::atomic<uint32_t>>(width * height * channels.size()).swap(bins);
+	totals.assign(width * height * channels.size(), 0);
+}
+
+
+unsigned int giulia::buddhabrot::get_channels() const {
+	return channels.size();
+}
+
+
+unsigned int giulia::buddhabrot::max_escape() const {
+
+	unsigned int m = 0;
+
+	for (size_t k = 0; k < channels.size(); ++k)
+		if(channels[k].max_iter > m)
+			m = channels[k].max_iter;
+
+	return m;
+}
+
+
+void giulia::buddhabrot::reduce() {
+
+	for (size_t i = 0; i < bins.size(); ++i)
+		totals[i] += bins[i].exchange(0, std::memory_order_relaxed);
+}
+
+
+void giulia::buddhabrot::render(unsigned long long samples, bool metropolis, uint64_t seed) {
+
+	if(!channels.size())
+		add_channel(20, 1000, pixel(255, 255, 255));
+
+	const unsigned int max_iter = max_escape();
+	const unsigned int n_channels = channels.size();
+	const unsigned int n_bins = width * height;
+
+	// View mapping
+	const double pixel_size = scale / width;
+	const double left = center_x - pixel_size * width / 2.0;
+	const double top = center_y + pixel_size * height / 2.0;
+
+	// Mutation radii of the Metropolis sampler, relative to the view
+	const double r_min = scale * 0.0001;
+	const double ln_r_ratio = th::ln(0.1 / 0.0001);
+
+	// Each sample adds at most max_iter hits to a bin, so reducing after
+	// this many samples guarantees the 32-bit bins never overflow
+	const unsigned long long round_size = ((1ULL << 32) - 1) / (max_iter ? max_iter : 1);
+
+	int n_threads = 1;
+
+#ifdef GIULIA_USE_OPENMP
+	n_threads = omp_get_max_threads();
+#endif
+
+	// Independent random streams and Metropolis chains for every thread
+	std::vector<buddhabrot_sampler> samplers;
+	samplers.reserve(n_threads);
+
+	for (int t = 0; t < n_threads; ++t)
+		samplers.emplace_back(th::rand_splitmix64(seed + t));
+
+	for (unsigned long long done = 0; done < samples; done += round_size) {
+
+		const unsigned long long round = (samples - done) < round_size
+			? (samples - done) : round_size;
+
+#ifdef GIULIA_USE_OPENMP
+#pragma omp parallel num_threads(n_threads)
+#endif
+		{
+			int t = 0;
+
+#ifdef GIULIA_USE_OPENMP
+			t = omp_get_thread_num();
+#endif
+
+			buddhabrot_sampler& s = samplers[t];
+			const unsigned long long share = round / n_threads + (t < (int) (round % n_threads));
+
+			// Trace the orbit of c, storing the bins it hits into <hits>
+			// and returning its escape time, or 0 if it does not escape
+			auto trace = [&](double c_a, double c_b, std::vector<uint32_t>& hits) -> unsigned int {
+
+				hits.clear();
+
+				if(in_main_bulbs(c_a, c_b))
+					return 0;
+
+				double z_a = 0, z_b = 0;
+
+				for (unsigned int i = 0; i < max_iter; ++i) {
+
+					const double tmp = z_a * z_a - z_b * z_b + c_a;
+					z_b = 2 * z_a * z_b + c_b;
+					z_a = tmp;
+
+					const long x = (long) ((z_a - left) / pixel_size);
+					const long y = (long) ((top - z_b) / pixel_size);
+
+					if(z_a >= left && z_b <= top && x < (long) width && y < (long) height)
+						hits.push_back(y * width + x);
+
+					if(z_a * z_a + z_b * z_b > 4)
+						return i + 1;
+				}
+
+				return 0;
+			};
+
+			// Accumulate the hits into the channels whose band contains the escape time
+			auto splat = [&](const std::vector<uint32_t>& hits, unsigned int escape) {
+
+				for (unsigned int k = 0; k < n_channels; ++k) {
+
+					if(escape < channels[k].min_iter || escape > channels[k].max_iter)
+						continue;
+
+					std::atomic<uint32_t>* channel_bins = &bins[k * n_bins];
+
+					for (size_t h = 0; h < hits.size(); ++h)
+						channel_bins[hits[h]].fetch_add(1, std::memory_order_relaxed);
+				}
+			};
+
+			// Whether an orbit contributes to the image
+			auto contributes = [&](const std::vector<uint32_t>& hits, unsigned int escape) {
+
+				if(!escape || !hits.size())
+					return false;
+
+				for (unsigned int k = 0; k < n_channels; ++k)
+					if(escape >= channels[k].min_iter && escape <= channels[k].max_iter)
+						return true;
+
+				return false;
+			};
+
+			// Look for a contributing starting point of the Metropolis chain
+			if(metropolis && !s.started) {
+
+				for (int tries = 0; tries < 100000 && !s.started; ++tries) {
+
+					s.c_a = s.uniform(-2, 2);
+					s.c_b = s.uniform(-2, 2);
+					s.escape = trace(s.c_a, s.c_b, s.current);
+					s.started = contributes(s.current, s.escape);
+				}
+			}
+
+			for (unsigned long long n = 0; n < share; ++n) {
+
+				// Uniform sampling over the square containing the set
+				if(!metropolis || !s.started) {
+
+					const double c_a = s.uniform(-2, 2);
+					const double c_b = s.uniform(-2, 2);
+					const unsigned int escape = trace(c_a, c_b, s.proposal);
+
+					if(escape)
+						splat(s.proposal, escape);
+
+					continue;
+				}
+
+				double c_a, c_b;
+
+				if(s.uniform(0, 1) < 0.2) {
+
+					// Large mutation, uniform over the square
+					c_a = s.uniform(-2, 2);
+					c_b = s.uniform(-2, 2);
+
+				} else {
+
+					// Small mutation with a log-uniform radius
+					const double r = r_min * std::exp(ln_r_ratio * s.uniform(0, 1));
+					const double phi = s.uniform(0, TAU);
+					c_a = s.c_a + r * std::cos(phi);
+					c_b = s.c_b + r * std::sin(phi);
+				}
+
+				const unsigned int escape = trace(c_a, c_b, s.proposal);
+				const double f_new = contributes(s.proposal, escape) ? s.proposal.size() : 0;
+				const double f_old = s.current.size();
+
+				// Accept with probability min(1, F(new) / F(old))
+				if(f_new > 0 && s.uniform(0, 1) * f_old < f_new) {
+					s.c_a = c_a;
+					s.c_b = c_b;
+					s.escape = escape;
+					s.current.swap(s.proposal);
+				}
+
+				splat(s.current, s.escape);
+			}
+		}
+
+		reduce();
+	}
+}
+
+
+std::vector<uint64_t> giulia::buddhabrot::get_histogram(unsigned int channel) {
+
+	reduce();
+
+	if(channel >= channels.size())
+		return std::vector<uint64_t>();
+
+	return std::vector<uint64_t>(
+		totals.begin() + channel * width * height,
+		totals.begin() + (channel + 1) * width * height);
+}
+
+
+void giulia::buddhabrot::draw(image& img, real_t gamma) {
+
+	reduce();
+
+	const unsigned int w = min(img.get_width(), width);
+	const unsigned int h = min(img.get_height(), height);
+	const unsigned int n_bins = width * height;
+
+	// Normalization of each channel by its densest bin
+	std::vector<real> inv_max(channels.size(), 0);
+
+	for (size_t k = 0; k < channels.size(); ++k) {
+
+		uint64_t m = 0;
+
+		for (unsigned int i = 0; i < n_bins; ++i)
+			if(totals[k * n_bins + i] > m)
+				m = totals[k * n_bins + i];
+
+		inv_max[k] = m ? 1.0 / m : 0;
+	}
+
+	for (unsigned int j = 0; j < h; ++j) {
+		for (unsigned int i = 0; i < w; ++i) {
+
+			real r = 0, g = 0, b = 0;
+
+			for (size_t k = 0; k < channels.size(); ++k) {
+
+				const uint64_t count = totals[k * n_bins + j * width + i];
+
+				if(!count)
+					continue;
+
+				const real v = th::powf(count * inv_max[k], gamma);
+				r += channels[k].color.r * v;
+				g += channels[k].color.g * v;
+				b += channels[k].color.b * v;
+			}
+
+			img[j * img.get_width() + i] = pixel(
+				clamp(r, 0, 255), clamp(g, 0, 255), clamp(b, 0, 255));
+		}
+	}
+}
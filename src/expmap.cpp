@@ -0,0 +1,239 @@
+#include "expmap.h"
+
+#define THEORETICA_LONG_DOUBLE_PREC
+#include "theoretica/core/real_analysis.h"
+#include "theoretica/core/constants.h"
+
+#include <cmath>
+#include <cstdio>
+
+using namespace giulia;
+using namespace theoretica;
+namespace th = theoretica;
+
+
+giulia::exp_map::exp_map(
+	real_t center_x, real_t center_y,
+	real_t r_max, real_t r_min, unsigned int width)
+	: center_x(center_x), center_y(center_y),
+	r_max(r_max), r_min(r_min), width(width) {
+
+	step = TAU / width;
+	height = std::ceil(std::log((double) (r_max / r_min)) / (double) step) + 1;
+}
+
+
+void giulia::exp_map::render(plane_function f) {
+
+	levels.assign(1, std::vector<float>(width * height * 3));
+	level_width.assign(1, width);
+	level_height.assign(1, height);
+
+	std::vector<float>& strip = levels[0];
+
+	// Deeper rows take more iterations, so rows are scheduled dynamically
+#ifdef GIULIA_USE_OPENMP
+#pragma omp parallel for schedule(dynamic, 1)
+#endif
+	for (int j = 0; j < (int) height; ++j) {
+
+		const double r = r_max * std::exp(-(double) (j * step));
+
+		for (unsigned int i = 0; i < width; ++i) {
+
+			const double theta = i * step;
+			const pixel p = f(center_x + r * std::cos(theta), center_y + r * std::sin(theta));
+
+			float* rgb = &strip[(j * width + i) * 3];
+			rgb[0] = p.r;
+			rgb[1] = p.g;
+			rgb[2] = p.b;
+		}
+	}
+
+	build_levels();
+}
+
+
+void giulia::exp_map::build_levels() {
+
+	while(level_width.back() >= 8 && level_height.back() >= 2) {
+
+		const std::vector<float>& src = levels.back();
+		const unsigned int w = level_width.back();
+		const unsigned int h = level_height.back();
+		const unsigned int nw = w / 2;
+		const unsigned int nh = (h + 1) / 2;
+
+		std::vector<float> dst(nw * nh * 3);
+
+		for (unsigned int j = 0; j < nh; ++j) {
+
+			const unsigned int j0 = 2 * j;
+			const unsigned int j1 = (2 * j + 1 < h) ? 2 * j + 1 : j0;
+
+			for (unsigned int i = 0; i < nw; ++i) {
+
+				// Columns wrap around the angle
+				const unsigned int i0 = 2 * i;
+				const unsigned int i1 = (2 * i + 1) % w;
+
+				for (unsigned int k = 0; k < 3; ++k)
+					dst[(j * nw + i) * 3 + k] = 0.25f * (
+						src[(j0 * w + i0) * 3 + k] + src[(j0 * w + i1) * 3 + k] +
+						src[(j1 * w + i0) * 3 + k] + src[(j1 * w + i1) * 3 + k]);
+			}
+		}
+
+		levels.push_back(dst);
+		level_width.push_back(nw);
+		level_height.push_back(nh);
+	}
+}
+
+
+void giulia::exp_map::sample(unsigned int l, real_t u, real_t v, float* rgb) const {
+
+	const std::vector<float>& strip = levels[l];
+	const unsigned int w = level_width[l];
+	const unsigned int h = level_height[l];
+
+	// Texel centers of the level, with columns wrapping around
+	u = (u + 0.5) * w / width - 0.5;
+	v = (v + 0.5) / (1 << l) - 0.5;
+
+	u -= w * std::floor(u / w);
+	v = v < 0 ? 0 : (v > h - 1 ? h - 1 : v);
+
+	const unsigned int i0 = (unsigned int) u % w;
+	const unsigned int j0 = v;
+	const unsigned int i1 = (i0 + 1) % w;
+	const unsigned int j1 = j0 + 1 < h ? j0 + 1 : j0;
+	const float a = u - std::floor(u);
+	const float b = v - j0;
+
+	for (unsigned int k = 0; k < 3; ++k)
+		rgb[k] =
+			(strip[(j0 * w + i0) * 3 + k] * (1 - a) + strip[(j0 * w + i1) * 3 + k] * a) * (1 - b) +
+			(strip[(j1 * w + i0) * 3 + k] * (1 - a) + strip[(j1 * w + i1) * 3 + k] * a) * b;
+}
+
+
+void giulia::exp_map::draw(image& img, real_t radius, plane_function f, real_t patch) const {
+
+	const unsigned int w = img.get_width();
+	const unsigned int h = img.get_height();
+	const unsigned int size = w * h;
+	const unsigned int max_level = levels.size() ? levels.size() - 1 : 0;
+
+	// Distance between neighbouring pixels in the plane
+	const double pixel_size = 2 * radius / (w - 1);
+
+#ifdef GIULIA_USE_OPENMP
+#pragma omp parallel for schedule(dynamic, 256)
+#endif
+	for (int i = 0; i < (int) size; ++i) {
+
+		real_t x, y;
+		pixel_coords(i, w, h, x, y);
+
+		const double dx = 2 * radius * x;
+		const double dy = 2 * radius * y;
+		const double r = std::sqrt(dx * dx + dy * dy);
+
+		// The center patch and the regions outside of the strip are drawn directly
+		if(!levels.size() || r < patch * radius || r < r_min || r > r_max) {
+			img[i] = f(center_x + dx, center_y + dy);
+			continue;
+		}
+
+		double theta = std::atan2(dy, dx);
+		if(theta < 0)
+			theta += TAU;
+
+		const real_t u = theta / step;
+		const real_t v = std::log((double) r_max / r) / step;
+
+		// Footprint of the pixel in samples of the strip, which grows towards
+		// the center, selecting and blending two levels of the mip chain
+		const double lod = std::log2(pixel_size / (r * step));
+		float rgb[3];
+
+		if(lod <= 0) {
+			sample(0, u, v, rgb);
+		} else if(lod >= max_level) {
+			sample(max_level, u, v, rgb);
+		} else {
+
+			const unsigned int l = lod;
+			const float t = lod - l;
+			float next[3];
+
+			sample(l, u, v, rgb);
+			sample(l + 1, u, v, next);
+
+			for (unsigned int k = 0; k < 3; ++k)
+				rgb[k] += (next[k] - rgb[k]) * t;
+		}
+
+		img[i] = pixel(rgb[0] + 0.5f, rgb[1] + 0.5f, rgb[2] + 0.5f);
+	}
+}
+
+
+int giulia::exp_map::render_frames(
+	unsigned int w, unsigned int h, unsigned int frames,
+	const std::string& prefix, plane_function f, real_t patch) const {
+
+	// The first frame fits the strip in its corners
+	// and the last one fits the strip outside of its patch
+	const real_t aspect_ratio = w / (real_t) h;
+	const real_t first = r_max / th::sqrt(1 + 1 / (aspect_ratio * aspect_ratio));
+	const real_t last = r_min / patch;
+
+	image img = image(w, h);
+	char number[16];
+
+	for (unsigned int k = 0; k < frames; ++k) {
+
+		const real_t t = frames > 1 ? k / (real_t) (frames - 1) : 0;
+		const real_t radius = first * std::pow((double) (last / first), (double) t);
+
+		draw(img, radius, f, patch);
+
+		std::snprintf(number, sizeof(number), "_%05u.bmp", k);
+
+		if(img.save(prefix + number))
+			return -1;
+	}
+
+	return 0;
+}
+
+
+void giulia::exp_map::draw_strip(image& img) const {
+
+	if(!levels.size())
+		return;
+
+	const unsigned int w = img.get_width() < width ? img.get_width() : width;
+	const unsigned int h = img.get_height() < height ? img.get_height() : height;
+
+	for (unsigned int j = 0; j < h; ++j) {
+		for (unsigned int i = 0; i < w; ++i) {
+
+			const float* rgb = &levels[0][(j * width + i) * 3];
+			img[j * img.get_width() + i] = pixel(rgb[0], rgb[1], rgb[2]);
+		}
+	}
+}
+
+
+unsigned int giulia::exp_map::get_width() const {
+	return width;
+}
+
+
+unsigned int giulia::exp_map::get_height() const {
+	return height;
+}
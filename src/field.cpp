@@ -0,0 +1,386 @@
+#include "field.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+using namespace giulia;
+
+
+namespace {
+
+	// Header of field files, followed by the sample planes
+	// as 32-bit floats in host byte order
+	struct field_header {
+		char magic[4];
+		uint32_t version;
+		uint32_t width;
+		uint32_t height;
+		uint32_t traps;
+		uint32_t max_iter;
+	};
+
+	const char field_magic[4] = {'G', 'F', 'L', 'D'};
+
+
+	// Iteration limit below which views are never estimated
+	const unsigned int min_auto_iter = 100;
+
+
+	// Whether a smooth iteration count reached the limit without escaping
+	inline bool capped(real_t iter, unsigned int max_iter) {
+		return !(iter < max_iter);
+	}
+
+
+	// Whether a smooth iteration count escaped in the second half of the limit
+	inline bool late(real_t iter, unsigned int max_iter) {
+		return iter >= max_iter / 2 && iter < max_iter;
+	}
+
+}
+
+
+giulia::iteration_field::iteration_field(
+	unsigned int w, unsigned int h, unsigned int traps, unsigned int max_iter)
+	: width(w), height(h), max_iter(max_iter) {
+
+	this->traps = traps < field_max_traps ? traps : field_max_traps;
+
+	iter.resize(w * h);
+	modulus.resize(w * h);
+	trap.resize(w * h * this->traps);
+	distance.resize(w * h);
+}
+
+
+field_sample giulia::iteration_field::get_sample(unsigned int i) const {
+
+	field_sample s;
+	s.iter = iter[i];
+	s.modulus = modulus[i];
+	s.distance = distance[i];
+
+	for (unsigned int k = 0; k < traps; ++k)
+		s.trap[k] = trap[k * width * height + i];
+
+	return s;
+}
+
+
+void giulia::iteration_field::set_sample(unsigned int i, const field_sample& s) {
+
+	iter[i] = s.iter;
+	modulus[i] = s.modulus;
+	distance[i] = s.distance;
+
+	for (unsigned int k = 0; k < traps; ++k)
+		trap[k * width * height + i] = s.trap[k];
+}
+
+
+unsigned int giulia::iteration_field::get_width() const {
+	return width;
+}
+
+
+unsigned int giulia::iteration_field::get_height() const {
+	return height;
+}
+
+
+unsigned int giulia::iteration_field::get_size() const {
+	return width * height;
+}
+
+
+unsigned int giulia::iteration_field::get_traps() const {
+	return traps;
+}
+
+
+unsigned int giulia::iteration_field::get_max_iter() const {
+	return max_iter;
+}
+
+
+void giulia::iteration_field::set_max_iter(unsigned int max_iter) {
+	this->max_iter = max_iter;
+}
+
+
+const float* giulia::iteration_field::get_iter() const {
+	return iter.data();
+}
+
+
+int giulia::iteration_field::save(const std::string& filename) const {
+
+	std::ofstream file(filename, std::ios::binary);
+
+	if(!file)
+		return -1;
+
+	field_header header;
+	std::memcpy(header.magic, field_magic, 4);
+	header.version = 2;
+	header.width = width;
+	header.height = height;
+	header.traps = traps;
+	header.max_iter = max_iter;
+
+	file.write((const char*) &header, sizeof(header));
+	file.write((const char*) iter.data(), iter.size() * sizeof(float));
+	file.write((const char*) modulus.data(), modulus.size() * sizeof(float));
+	file.write((const char*) trap.data(), trap.size() * sizeof(float));
+	file.write((const char*) distance.data(), distance.size() * sizeof(float));
+
+	return file ? 0 : -1;
+}
+
+
+int giulia::iteration_field::load(const std::string& filename) {
+
+	std::ifstream file(filename, std::ios::binary);
+
+	if(!file)
+		return -1;
+
+	field_header header;
+	file.read((char*) &header, sizeof(header));
+
+	if(!file || std::memcmp(header.magic, field_magic, 4)
+		|| header.version < 1 || header.version > 2
+		|| header.traps > field_max_traps)
+		return -1;
+
+	iteration_field f = iteration_field(
+		header.width, header.height, header.traps, header.max_iter);
+
+	file.read((char*) f.iter.data(), f.iter.size() * sizeof(float));
+	file.read((char*) f.modulus.data(), f.modulus.size() * sizeof(float));
+	file.read((char*) f.trap.data(), f.trap.size() * sizeof(float));
+
+	// Distance estimates were added in version 2
+	if(header.version >= 2)
+		file.read((char*) f.distance.data(), f.distance.size() * sizeof(float));
+
+	if(!file)
+		return -1;
+
+	*this = f;
+	return 0;
+}
+
+
+void giulia::compute_field(iteration_field& f, global_state& state, sample_function sample) {
+
+	const unsigned int w = f.get_width();
+	const unsigned int h = f.get_height();
+
+#ifdef GIULIA_USE_OPENMP
+#pragma omp parallel for
+#endif
+
+	for (int i = 0; i < (int) f.get_size(); ++i) {
+
+		real_t x, y;
+		pixel_coords(i, w, h, x, y);
+		f.set_sample(i, sample(x, y, state));
+	}
+}
+
+
+unsigned int giulia::auto_max_iter(
+	global_state& state, sample_function sample,
+	unsigned int probe, real_t threshold, unsigned int limit) {
+
+	// Deeper zooms need a number of iterations growing with
+	// the number of halvings of the view from the whole set
+	const real_t scale = state["scale.x"] > 0 ? state["scale.x"] : 4;
+	const real_t depth = scale < 4 ? std::log2((double) (4 / scale)) : 0;
+	unsigned int max_iter = min_auto_iter * (1 + depth);
+
+	if(max_iter > limit)
+		max_iter = limit;
+
+	const real_t aspect_ratio = state["aspect_ratio"] > 0 ? state["aspect_ratio"] : 1;
+	const unsigned int w = probe > 1 ? probe : 2;
+	const unsigned int h = (w / aspect_ratio) > 1 ? (w / aspect_ratio) : 2;
+
+	std::vector<real_t> iters(w * h);
+
+	for(;;) {
+
+		state["max_iter"] = max_iter;
+
+#ifdef GIULIA_USE_OPENMP
+#pragma omp parallel for schedule(dynamic, 16)
+#endif
+		for (int i = 0; i < (int) (w * h); ++i) {
+
+			real_t x, y;
+			pixel_coords(i, w, h, x, y);
+			iters[i] = sample(x, y, state).iter;
+		}
+
+		unsigned int n_late = 0;
+		unsigned int n_capped = 0;
+
+		for (unsigned int i = 0; i < w * h; ++i) {
+			n_late += late(iters[i], max_iter);
+			n_capped += capped(iters[i], max_iter);
+		}
+
+		// Stop once the pixels at the limit are unlikely to escape
+		if(!n_capped || n_late <= threshold * w * h || max_iter >= limit)
+			break;
+
+		max_iter = (2 * max_iter < limit) ? 2 * max_iter : limit;
+	}
+
+	state["max_iter"] = max_iter;
+	return max_iter;
+}
+
+
+void giulia::compute_field_adaptive(
+	iteration_field& f, global_state& state, sample_function sample,
+	unsigned int tile, real_t threshold, unsigned int limit) {
+
+	const unsigned int w = f.get_width();
+	const unsigned int h = f.get_height();
+	const unsigned int base_iter = state["max_iter"] > 0 ? state["max_iter"] : f.get_max_iter();
+
+	if(!tile)
+		tile = 32;
+
+	const unsigned int tiles_x = (w + tile - 1) / tile;
+	const unsigned int tiles_y = (h + tile - 1) / tile;
+
+	// Iteration limit reached by each tile
+	std::vector<unsigned int> tile_iter(tiles_x * tiles_y, base_iter);
+
+#ifdef GIULIA_USE_OPENMP
+#pragma omp parallel for schedule(dynamic, 1)
+#endif
+	for (int t = 0; t < (int) (tiles_x * tiles_y); ++t) {
+
+		const unsigned int i_begin = (t % tiles_x) * tile;
+		const unsigned int j_begin = (t / tiles_x) * tile;
+		const unsigned int i_end = (i_begin + tile < w) ? i_begin + tile : w;
+		const unsigned int j_end = (j_begin + tile < h) ? j_begin + tile : h;
+		const unsigned int n = (i_end - i_begin) * (j_end - j_begin);
+
+		// Every tile samples with its own limit
+		global_state local = state;
+		unsigned int max_iter = base_iter;
+		local["max_iter"] = max_iter;
+
+		for (unsigned int j = j_begin; j < j_end; ++j) {
+			for (unsigned int i = i_begin; i < i_end; ++i) {
+
+				real_t x, y;
+				pixel_coords(j * w + i, w, h, x, y);
+				f.set_sample(j * w + i, sample(x, y, local));
+			}
+		}
+
+		for(;;) {
+
+			unsigned int n_late = 0;
+			unsigned int n_capped = 0;
+
+			for (unsigned int j = j_begin; j < j_end; ++j) {
+				for (unsigned int i = i_begin; i < i_end; ++i) {
+
+					const real_t iter = f.get_sample(j * w + i).iter;
+					n_late += late(iter, max_iter);
+					n_capped += capped(iter, max_iter);
+				}
+			}
+
+			if(!n_capped || n_late <= threshold * n || max_iter >= limit)
+				break;
+
+			// Orbits which escaped are unaffected by a higher limit,
+			// so only the pixels at the limit are sampled again
+			const unsigned int prev_iter = max_iter;
+			max_iter = (2 * max_iter < limit) ? 2 * max_iter : limit;
+			local["max_iter"] = max_iter;
+
+			for (unsigned int j = j_begin; j < j_end; ++j) {
+				for (unsigned int i = i_begin; i < i_end; ++i) {
+
+					if(!capped(f.get_sample(j * w + i).iter, prev_iter))
+						continue;
+
+					real_t x, y;
+					pixel_coords(j * w + i, w, h, x, y);
+					f.set_sample(j * w + i, sample(x, y, local));
+				}
+			}
+		}
+
+		tile_iter[t] = max_iter;
+	}
+
+	unsigned int max_iter = base_iter;
+	unsigned int raised = 0;
+
+	for (unsigned int t = 0; t < tile_iter.size(); ++t) {
+		max_iter = tile_iter[t] > max_iter ? tile_iter[t] : max_iter;
+		raised += tile_iter[t] > base_iter;
+	}
+
+	// Pixels at the limit of their tile are interior points for the whole field
+	for (unsigned int t = 0; t < tile_iter.size(); ++t) {
+
+		if(tile_iter[t] == max_iter)
+			continue;
+
+		const unsigned int i_begin = (t % tiles_x) * tile;
+		const unsigned int j_begin = (t / tiles_x) * tile;
+		const unsigned int i_end = (i_begin + tile < w) ? i_begin + tile : w;
+		const unsigned int j_end = (j_begin + tile < h) ? j_begin + tile : h;
+
+		for (unsigned int j = j_begin; j < j_end; ++j) {
+			for (unsigned int i = i_begin; i < i_end; ++i) {
+
+				field_sample s = f.get_sample(j * w + i);
+
+				if(capped(s.iter, tile_iter[t])) {
+					s.iter = max_iter;
+					f.set_sample(j * w + i, s);
+				}
+			}
+		}
+	}
+
+	f.set_max_iter(max_iter);
+	state["max_iter.raised"] = raised;
+	state["max_iter.peak"] = max_iter;
+}
+
+
+void giulia::shade_field(const iteration_field& f, image& img, shade_function shade) {
+
+	const unsigned int w = f.get_width();
+	const unsigned int h = f.get_height();
+
+	if(img.get_width() != w || img.get_height() != h)
+		return;
+
+#ifdef GIULIA_USE_OPENMP
+#pragma omp parallel for
+#endif
+
+	for (int i = 0; i < (int) f.get_size(); ++i) {
+
+		real_t x, y;
+		pixel_coords(i, w, h, x, y);
+		img[i] = shade(f.get_sample(i), x, y);
+	}
+}
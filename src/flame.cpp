@@ -0,0 +1,294 @@
+#include "flame.h"
+
+#define THEORETICA_LONG_DOUBLE_PREC
+#include "theoretica/theoretica.h"
+
+#include <cmath>
+#include <algorithm>
+
+#ifdef GIULIA_USE_OPENMP
+#include <omp.h>
+#endif
+
+using namespace giulia;
+using namespace theoretica;
+namespace th = theoretica;
+
+
+namespace {
+
+
+	// A transform prepared for the chaos game
+	struct flame_map {
+		double a, b, c, d, e, f;
+		int variation;
+		float r, g, b_color;
+	};
+
+
+	// Apply the variation of a transform to a point
+	inline void apply_variation(int variation, double& x, double& y) {
+
+		switch(variation) {
+
+			case VAR_SINUSOIDAL:
+				x = std::sin(x);
+				y = std::sin(y);
+				break;
+
+			case VAR_SPHERICAL: {
+				const double r2 = x * x + y * y + 1E-12;
+				x /= r2;
+				y /= r2;
+				break;
+			}
+
+			case VAR_SWIRL: {
+				const double r2 = x * x + y * y;
+				const double s = std::sin(r2);
+				const double c = std::cos(r2);
+				const double t = x * s - y * c;
+				y = x * c + y * s;
+				x = t;
+				break;
+			}
+
+			case VAR_HORSESHOE: {
+				const double r = std::sqrt(x * x + y * y) + 1E-12;
+				const double t = (x - y) * (x + y) / r;
+				y = 2 * x * y / r;
+				x = t;
+				break;
+			}
+
+			case VAR_POLAR: {
+				const double t = std::atan2(x, y) / PI;
+				y = std::sqrt(x * x + y * y) - 1;
+				x = t;
+				break;
+			}
+
+			default: break;
+		}
+	}
+
+}
+
+
+giulia::flame::flame(
+	unsigned int width, unsigned int height,
+	real_t x_min, real_t y_min, real_t x_max, real_t y_max)
+	: width(width), height(height),
+	x_min(x_min), y_min(y_min), x_max(x_max), y_max(y_max) {
+
+	counts.assign(width * height, 0);
+	colors.assign(3 * width * height, 0);
+}
+
+
+void giulia::flame::add_transform(const flame_transform& t) {
+	transforms.push_back(t);
+}
+
+
+void giulia::flame::render(unsigned long long samples, uint64_t seed) {
+
+	const unsigned int n = transforms.size();
+
+	if(!n)
+		return;
+
+	// Cumulative weights for choosing transforms
+	std::vector<double> cumulative(n);
+	std::vector<flame_map> maps(n);
+	double total_weight = 0;
+
+	for (unsigned int k = 0; k < n; ++k) {
+
+		const flame_transform& t = transforms[k];
+		total_weight += t.weight;
+		cumulative[k] = total_weight;
+
+		flame_map m = {
+			(double) t.a, (double) t.b, (double) t.c,
+			(double) t.d, (double) t.e, (double) t.f,
+			t.variation, (float) t.color.r, (float) t.color.g, (float) t.color.b
+		};
+		maps[k] = m;
+	}
+
+	// View mapping
+	const double sx = width / (double) (x_max - x_min);
+	const double sy = height / (double) (y_max - y_min);
+	const double left = x_min;
+	const double top = y_max;
+	const unsigned int n_bins = width * height;
+
+	int n_threads = 1;
+
+#ifdef GIULIA_USE_OPENMP
+	n_threads = omp_get_max_threads();
+#endif
+
+#ifdef GIULIA_USE_OPENMP
+#pragma omp parallel num_threads(n_threads)
+#endif
+	{
+		int t = 0;
+
+#ifdef GIULIA_USE_OPENMP
+		t = omp_get_thread_num();
+#endif
+
+		// Independent random stream of the thread
+		PRNG g = PRNG::xoshiro(th::rand_splitmix64(seed + t));
+		const double to_unit = 1.0 / 9007199254740992.0;
+
+		// Thread local density: count and color of each bin
+		std::vector<float> density(4 * n_bins, 0);
+
+		// Float bins count exactly up to 2^24 points, so that they are merged
+		// into the totals before any of them may exceed it
+		const unsigned long long window = 1ULL << 24;
+		unsigned long long binned = 0;
+
+		auto merge = [&]() {
+
+#ifdef GIULIA_USE_OPENMP
+#pragma omp critical
+#endif
+			{
+				for (unsigned int i = 0; i < n_bins; ++i) {
+					counts[i] += density[4 * i];
+					colors[3 * i] += density[4 * i + 1];
+					colors[3 * i + 1] += density[4 * i + 2];
+					colors[3 * i + 2] += density[4 * i + 3];
+				}
+			}
+
+			std::fill(density.begin(), density.end(), 0);
+			binned = 0;
+		};
+
+		const unsigned long long share = samples / n_threads
+			+ ((unsigned long long) t < samples % n_threads);
+
+		// Initial iterations which are not plotted, until the point reaches the attractor
+		const unsigned int fuse = 20;
+
+		double x = 0, y = 0;
+		float r = 0, gr = 0, b = 0;
+		unsigned int skip = 0;
+		unsigned int restarts = 0;
+		bool restart = true;
+		unsigned long long plotted = 0;
+
+		while(plotted < share) {
+
+			if(restart) {
+
+				// Give up on systems which always diverge
+				if(++restarts > 1000)
+					break;
+
+				x = 2 * ((g() >> 11) * to_unit) - 1;
+				y = 2 * ((g() >> 11) * to_unit) - 1;
+				skip = fuse;
+				restart = false;
+			}
+
+			// Weighted choice of the transform
+			const double u = ((g() >> 11) * to_unit) * total_weight;
+			unsigned int k = 0;
+
+			while(k < n - 1 && u >= cumulative[k])
+				k++;
+
+			const flame_map& m = maps[k];
+
+			const double tx = m.a * x + m.b * y + m.c;
+			y = m.d * x + m.e * y + m.f;
+			x = tx;
+			apply_variation(m.variation, x, y);
+
+			// Restart from a random point when the orbit diverges
+			if(!std::isfinite(x) || !std::isfinite(y)) {
+				restart = true;
+				continue;
+			}
+
+			r = (r + m.r) * 0.5f;
+			gr = (gr + m.g) * 0.5f;
+			b = (b + m.b_color) * 0.5f;
+
+			if(skip) {
+				skip--;
+				continue;
+			}
+
+			restarts = 0;
+			plotted++;
+
+			const double fx = (x - left) * sx;
+			const double fy = (top - y) * sy;
+
+			if(fx < 0 || fy < 0 || fx >= width || fy >= height)
+				continue;
+
+			if(binned == window)
+				merge();
+
+			float* bin = &density[4 * ((unsigned int) fy * width + (unsigned int) fx)];
+			bin[0] += 1;
+			bin[1] += r;
+			bin[2] += gr;
+			bin[3] += b;
+			binned++;
+		}
+
+		// Merge the rest of the thread local density
+		merge();
+	}
+}
+
+
+real_t giulia::flame::density(unsigned int i, unsigned int j) const {
+	return counts[j * width + i];
+}
+
+
+void giulia::flame::draw(image& img, real_t gamma, real_t brightness) {
+
+	const unsigned int w = min(img.get_width(), width);
+	const unsigned int h = min(img.get_height(), height);
+
+	double max_count = 0;
+
+	for (size_t i = 0; i < counts.size(); ++i)
+		if(counts[i] > max_count)
+			max_count = counts[i];
+
+	if(max_count == 0)
+		return;
+
+	const double inv_log_max = 1.0 / std::log1p(max_count);
+
+	for (unsigned int j = 0; j < h; ++j) {
+		for (unsigned int i = 0; i < w; ++i) {
+
+			const unsigned int k = j * width + i;
+
+			if(counts[k] == 0)
+				continue;
+
+			// Log-density alpha with gamma correction
+			const double alpha = std::pow(std::log1p(counts[k]) * inv_log_max, 1.0 / gamma);
+			const double scale = brightness * alpha / counts[k];
+
+			img[j * img.get_width() + i] = pixel(
+				clamp(colors[3 * k] * scale, 0, 255),
+				clamp(colors[3 * k + 1] * scale, 0, 255),
+				clamp(colors[3 * k + 2] * scale, 0, 255));
+		}
+	}
+}
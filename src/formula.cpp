@@ -0,0 +1,886 @@
+#include "formula.h"
+
+#define THEORETICA_LONG_DOUBLE_PREC
+#include "theoretica/theoretica.h"
+
+#include <cctype>
+#include <cstdlib>
+#include <cmath>
+#include <map>
+#include <tuple>
+#include <sstream>
+
+using namespace giulia;
+using namespace theoretica;
+namespace th = theoretica;
+
+
+namespace {
+
+
+	// Bytecode operations
+	enum formula_op {
+		OP_ADD, OP_SUB, OP_MUL, OP_DIV, OP_NEG,
+		OP_POWI, OP_POW, OP_SIN, OP_COS, OP_TAN,
+		OP_EXP, OP_LN, OP_SQRT, OP_CONJ,
+
+		// Leaves of the expression graph, which never become instructions
+		NODE_Z, NODE_C, NODE_CONST
+	};
+
+
+	const char* op_names[] = {
+		"add", "sub", "mul", "div", "neg",
+		"powi", "pow", "sin", "cos", "tan",
+		"exp", "ln", "sqrt", "conj"
+	};
+
+
+	// A node of the expression graph
+	struct formula_node {
+		int op;
+		int a;
+		int b;
+		int n;
+		complex value;
+	};
+
+
+	// Integer power by repeated squaring
+	complex powi(complex z, int n) {
+
+		if(n < 0)
+			return powi(z, -n).inverse();
+
+		complex res = complex(1, 0);
+
+		while(n) {
+
+			if(n & 1)
+				res = res * z;
+
+			z = z * z;
+			n >>= 1;
+		}
+
+		return res;
+	}
+
+
+	// Scalar semantics of an operation, used for constant folding
+	// and by the single point interpreter
+	complex apply_op(int op, complex a, complex b, int n) {
+
+		switch(op) {
+			case OP_ADD: return a + b;
+			case OP_SUB: return a - b;
+			case OP_MUL: return a * b;
+			case OP_DIV: return a / b;
+			case OP_NEG: return -a;
+			case OP_POWI: return powi(a, n);
+			case OP_POW:
+				if(a.square_modulus() == 0)
+					return complex(0, 0);
+				return th::exp(b * th::ln(a));
+			case OP_SIN: return th::sin(a);
+			case OP_COS: return th::cos(a);
+			case OP_TAN: return th::tan(a);
+			case OP_EXP: return th::exp(a);
+			case OP_LN: return th::ln(a);
+			case OP_SQRT: return th::sqrt(a);
+			case OP_CONJ: return a.conjugate();
+			default: return complex(nan(), nan());
+		}
+	}
+
+
+	// Recursive descent parser building a folded and deduplicated expression graph
+	struct formula_parser {
+
+		const std::string& s;
+		size_t pos {0};
+		std::vector<formula_node> nodes;
+		std::map<std::tuple<int, int, int, int>, int> cse;
+		std::string error;
+
+		formula_parser(const std::string& s) : s(s) {}
+
+
+		void skip() {
+			while(pos < s.size() && std::isspace(s[pos]))
+				pos++;
+		}
+
+
+		bool accept(char ch) {
+
+			skip();
+
+			if(pos < s.size() && s[pos] == ch) {
+				pos++;
+				return true;
+			}
+
+			return false;
+		}
+
+
+		int fail(const std::string& msg) {
+
+			if(error.empty())
+				error = msg + " at position " + std::to_string(pos);
+
+			return -1;
+		}
+
+
+		int constant(complex v) {
+
+			for (size_t i = 0; i < nodes.size(); ++i)
+				if(nodes[i].op == NODE_CONST && nodes[i].value == v)
+					return i;
+
+			formula_node node = {NODE_CONST, -1, -1, 0, v};
+			nodes.push_back(node);
+			return nodes.size() - 1;
+		}
+
+
+		bool is_const(int i, real value) {
+			return nodes[i].op == NODE_CONST && nodes[i].value == complex(value, 0);
+		}
+
+
+		// Create a node, folding constants and reusing identical subexpressions
+		int make(int op, int a, int b = -1, int n = 0) {
+
+			if(a < 0 || (b < 0 && (op == OP_ADD || op == OP_SUB || op == OP_MUL
+				|| op == OP_DIV || op == OP_POW)))
+				return -1;
+
+			const bool unary = (b < 0);
+
+			// Constant folding
+			if(nodes[a].op == NODE_CONST && (unary || nodes[b].op == NODE_CONST))
+				return constant(apply_op(op, nodes[a].value,
+					unary ? complex() : nodes[b].value, n));
+
+			// Algebraic identities
+			switch(op) {
+				case OP_ADD:
+					if(is_const(a, 0)) return b;
+					if(is_const(b, 0)) return a;
+					break;
+				case OP_SUB:
+					if(is_const(b, 0)) return a;
+					if(is_const(a, 0)) return make(OP_NEG, b);
+					break;
+				case OP_MUL:
+					if(is_const(a, 1)) return b;
+					if(is_const(b, 1)) return a;
+					break;
+				case OP_DIV:
+					if(is_const(b, 1)) return a;
+					break;
+				case OP_POW:
+					if(nodes[b].op == NODE_CONST && nodes[b].value.Im() == 0
+						&& nodes[b].value.Re() == std::floor(nodes[b].value.Re())
+						&& std::fabs(nodes[b].value.Re()) <= 64)
+						return make(OP_POWI, a, -1, (int) nodes[b].value.Re());
+					break;
+				case OP_POWI:
+					if(n == 0) return constant(complex(1, 0));
+					if(n == 1) return a;
+					break;
+				case OP_NEG:
+					if(nodes[a].op == OP_NEG) return nodes[a].a;
+					break;
+				default: break;
+			}
+
+			// Commutative operations are stored with sorted operands
+			if((op == OP_ADD || op == OP_MUL) && b < a)
+				std::swap(a, b);
+
+			// Common subexpression elimination
+			const auto key = std::make_tuple(op, a, b, n);
+			const auto it = cse.find(key);
+
+			if(it != cse.end())
+				return it->second;
+
+			formula_node node = {op, a, b, n, complex()};
+			nodes.push_back(node);
+			cse[key] = nodes.size() - 1;
+
+			return nodes.size() - 1;
+		}
+
+
+		// expr := term (('+' | '-') term)*
+		int expr() {
+
+			int lhs = term();
+
+			while(lhs >= 0) {
+
+				if(accept('+'))
+					lhs = make(OP_ADD, lhs, term());
+				else if(accept('-'))
+					lhs = make(OP_SUB, lhs, term());
+				else
+					break;
+			}
+
+			return lhs;
+		}
+
+
+		// term := unary (('*' | '/') unary)*
+		int term() {
+
+			int lhs = unary();
+
+			while(lhs >= 0) {
+
+				if(accept('*'))
+					lhs = make(OP_MUL, lhs, unary());
+				else if(accept('/'))
+					lhs = make(OP_DIV, lhs, unary());
+				else
+					break;
+			}
+
+			return lhs;
+		}
+
+
+		// unary := '-' unary | '+' unary | power
+		int unary() {
+
+			if(accept('-'))
+				return make(OP_NEG, unary());
+
+			if(accept('+'))
+				return unary();
+
+			return power();
+		}
+
+
+		// power := primary ('^' unary)?
+		int power() {
+
+			int base = primary();
+
+			if(base >= 0 && accept('^'))
+				return make(OP_POW, base, unary());
+
+			return base;
+		}
+
+
+		// primary := number | variable | function '(' expr ')' | '(' expr ')'
+		int primary() {
+
+			skip();
+
+			if(pos >= s.size())
+				return fail("Unexpected end of formula");
+
+			if(accept('(')) {
+
+				int e = expr();
+
+				if(e >= 0 && !accept(')'))
+					return fail("Expected ')'");
+
+				return e;
+			}
+
+			if(std::isdigit(s[pos]) || s[pos] == '.') {
+
+				const char* begin = s.c_str() + pos;
+				char* end = nullptr;
+				real value = std::strtold(begin, &end);
+
+				if(end == begin)
+					return fail("Invalid number");
+
+				pos += end - begin;
+
+				return constant(complex(value, 0));
+			}
+
+			if(!std::isalpha(s[pos]))
+				return fail(std::string("Unexpected character '") + s[pos] + "'");
+
+			size_t start = pos;
+			while(pos < s.size() && std::isalnum(s[pos]))
+				pos++;
+
+			const std::string name = s.substr(start, pos - start);
+
+			if(name == "z") {
+				formula_node node = {NODE_Z, -1, -1, 0, complex()};
+				return leaf(node);
+			}
+
+			if(name == "c") {
+				formula_node node = {NODE_C, -1, -1, 0, complex()};
+				return leaf(node);
+			}
+
+			if(name == "i")
+				return constant(complex(0, 1));
+
+			static const std::map<std::string, int> functions = {
+				{"sin", OP_SIN}, {"cos", OP_COS}, {"tan", OP_TAN},
+				{"exp", OP_EXP}, {"ln", OP_LN}, {"sqrt", OP_SQRT},
+				{"conj", OP_CONJ}
+			};
+
+			const auto f = functions.find(name);
+
+			if(f == functions.end())
+				return fail("Unknown identifier '" + name + "'");
+
+			if(!accept('('))
+				return fail("Expected '(' after function name");
+
+			int arg = expr();
+
+			if(arg >= 0 && !accept(')'))
+				return fail("Expected ')'");
+
+			return make(f->second, arg);
+		}
+
+
+		int leaf(formula_node node) {
+
+			for (size_t i = 0; i < nodes.size(); ++i)
+				if(nodes[i].op == node.op)
+					return i;
+
+			nodes.push_back(node);
+			return nodes.size() - 1;
+		}
+
+	};
+
+}
+
+
+giulia::formula::formula(const std::string& expr) {
+	compile(expr);
+}
+
+
+int giulia::formula::compile(const std::string& expr) {
+
+	code.clear();
+	constants.clear();
+	n_regs = 0;
+	result = 0;
+	error.clear();
+
+	formula_parser parser = formula_parser(expr);
+	int root = parser.expr();
+
+	parser.skip();
+	if(root >= 0 && parser.pos != expr.size())
+		root = parser.fail("Unexpected trailing input");
+
+	if(root < 0) {
+		error = parser.error.empty() ? "Invalid formula" : parser.error;
+		return -1;
+	}
+
+	const std::vector<formula_node>& nodes = parser.nodes;
+
+	// Mark the nodes reachable from the root, dropping the
+	// intermediate results of constant folding
+	std::vector<bool> live(nodes.size(), false);
+	live[root] = true;
+
+	for (int i = root; i >= 0; --i) {
+
+		if(!live[i])
+			continue;
+
+		if(nodes[i].a >= 0) live[nodes[i].a] = true;
+		if(nodes[i].b >= 0) live[nodes[i].b] = true;
+	}
+
+	// Registers 0 and 1 hold z and c, followed by the constants
+	std::vector<int> reg(nodes.size(), -1);
+	n_regs = 2;
+
+	for (size_t i = 0; i < nodes.size(); ++i) {
+
+		if(!live[i])
+			continue;
+
+		if(nodes[i].op == NODE_Z)
+			reg[i] = 0;
+		else if(nodes[i].op == NODE_C)
+			reg[i] = 1;
+		else if(nodes[i].op == NODE_CONST) {
+			constants.push_back({nodes[i].value.Re(), nodes[i].value.Im()});
+			reg[i] = n_regs++;
+		}
+	}
+
+	// Last use of each node, for register reuse
+	std::vector<int> last_use(nodes.size(), -1);
+
+	for (size_t i = 0; i < nodes.size(); ++i) {
+
+		if(!live[i] || nodes[i].op >= NODE_Z)
+			continue;
+
+		if(nodes[i].a >= 0) last_use[nodes[i].a] = i;
+		if(nodes[i].b >= 0) last_use[nodes[i].b] = i;
+	}
+
+	// Linear scan allocation of temporary registers
+	std::vector<unsigned short> free_regs;
+
+	for (size_t i = 0; i < nodes.size(); ++i) {
+
+		if(!live[i] || nodes[i].op >= NODE_Z)
+			continue;
+
+		const formula_node& node = nodes[i];
+
+		// Release operands which are not used anymore
+		const int operands[2] = {node.a, node.b};
+
+		for (int k = 0; k < 2; ++k) {
+
+			const int o = operands[k];
+
+			if(o >= 0 && nodes[o].op < NODE_Z && last_use[o] == (int) i
+				&& (k == 0 || o != node.a))
+				free_regs.push_back(reg[o]);
+		}
+
+		if(free_regs.size()) {
+			reg[i] = free_regs.back();
+			free_regs.pop_back();
+		} else {
+			reg[i] = n_regs++;
+		}
+
+		formula_instruction instr;
+		instr.op = node.op;
+		instr.dst = reg[i];
+		instr.a = reg[node.a];
+		instr.b = node.b >= 0 ? reg[node.b] : 0;
+		instr.n = node.n;
+		code.push_back(instr);
+	}
+
+	result = reg[root];
+	return 0;
+}
+
+
+bool giulia::formula::valid() const {
+	return error.empty();
+}
+
+
+std::string giulia::formula::get_error() const {
+	return error;
+}
+
+
+unsigned int giulia::formula::size() const {
+	return code.size();
+}
+
+
+unsigned int giulia::formula::registers() const {
+	return n_regs;
+}
+
+
+std::array<real_t, 2> giulia::formula::operator()(
+	real_t z_a, real_t z_b, real_t c_a, real_t c_b) const {
+
+	std::vector<real_t> regs(2 * n_regs);
+	eval(z_a, z_b, c_a, c_b, &regs[0]);
+
+	return {z_a, z_b};
+}
+
+
+void giulia::formula::eval(
+	real_t& z_a, real_t& z_b, real_t c_a, real_t c_b, real_t* regs) const {
+
+	if(!valid()) {
+		z_a = nan();
+		z_b = nan();
+		return;
+	}
+
+	regs[0] = z_a;
+	regs[1] = z_b;
+	regs[2] = c_a;
+	regs[3] = c_b;
+
+	for (size_t k = 0; k < constants.size(); ++k) {
+		regs[2 * (k + 2)] = constants[k][0];
+		regs[2 * (k + 2) + 1] = constants[k][1];
+	}
+
+	for (size_t k = 0; k < code.size(); ++k) {
+
+		const formula_instruction& instr = code[k];
+
+		const complex res = apply_op(instr.op,
+			complex(regs[2 * instr.a], regs[2 * instr.a + 1]),
+			complex(regs[2 * instr.b], regs[2 * instr.b + 1]),
+			instr.n);
+
+		regs[2 * instr.dst] = res.Re();
+		regs[2 * instr.dst + 1] = res.Im();
+	}
+
+	z_a = regs[2 * result];
+	z_b = regs[2 * result + 1];
+}
+
+
+void giulia::formula::eval(
+	double* z_a, double* z_b, const double* c_a, const double* c_b,
+	unsigned int n, double* regs) const {
+
+	const unsigned int B = batch_size;
+
+	if(!valid() || n > B) {
+		for (unsigned int l = 0; l < n; ++l)
+			z_a[l] = z_b[l] = nan();
+		return;
+	}
+
+	// Real and imaginary parts of register r
+	#define RE(r) (regs + (2 * (r)) * B)
+	#define IM(r) (regs + (2 * (r) + 1) * B)
+
+	for (unsigned int l = 0; l < n; ++l) {
+		RE(0)[l] = z_a[l];
+		IM(0)[l] = z_b[l];
+		RE(1)[l] = c_a[l];
+		IM(1)[l] = c_b[l];
+	}
+
+	for (size_t k = 0; k < constants.size(); ++k) {
+
+		const double re = constants[k][0];
+		const double im = constants[k][1];
+
+		for (unsigned int l = 0; l < n; ++l) {
+			RE(k + 2)[l] = re;
+			IM(k + 2)[l] = im;
+		}
+	}
+
+	// Each instruction is dispatched once and applied to the whole batch
+	for (size_t k = 0; k < code.size(); ++k) {
+
+		const formula_instruction& instr = code[k];
+
+		double* d_re = RE(instr.dst);
+		double* d_im = IM(instr.dst);
+		const double* a_re = RE(instr.a);
+		const double* a_im = IM(instr.a);
+		const double* b_re = RE(instr.b);
+		const double* b_im = IM(instr.b);
+
+		switch(instr.op) {
+
+			case OP_ADD:
+				for (unsigned int l = 0; l < n; ++l) {
+					const double re = a_re[l] + b_re[l];
+					const double im = a_im[l] + b_im[l];
+					d_re[l] = re; d_im[l] = im;
+				}
+				break;
+
+			case OP_SUB:
+				for (unsigned int l = 0; l < n; ++l) {
+					const double re = a_re[l] - b_re[l];
+					const double im = a_im[l] - b_im[l];
+					d_re[l] = re; d_im[l] = im;
+				}
+				break;
+
+			case OP_MUL:
+				for (unsigned int l = 0; l < n; ++l) {
+					const double re = a_re[l] * b_re[l] - a_im[l] * b_im[l];
+					const double im = a_re[l] * b_im[l] + a_im[l] * b_re[l];
+					d_re[l] = re; d_im[l] = im;
+				}
+				break;
+
+			case OP_DIV:
+				for (unsigned int l = 0; l < n; ++l) {
+					const double m = b_re[l] * b_re[l] + b_im[l] * b_im[l];
+					const double re = (a_re[l] * b_re[l] + a_im[l] * b_im[l]) / m;
+					const double im = (a_im[l] * b_re[l] - a_re[l] * b_im[l]) / m;
+					d_re[l] = re; d_im[l] = im;
+				}
+				break;
+
+			case OP_NEG:
+				for (unsigned int l = 0; l < n; ++l) {
+					d_re[l] = -a_re[l];
+					d_im[l] = -a_im[l];
+				}
+				break;
+
+			case OP_CONJ:
+				for (unsigned int l = 0; l < n; ++l) {
+					d_re[l] = a_re[l];
+					d_im[l] = -a_im[l];
+				}
+				break;
+
+			case OP_POWI:
+				for (unsigned int l = 0; l < n; ++l) {
+
+					double x_re = a_re[l], x_im = a_im[l];
+					double r_re = 1, r_im = 0;
+					int e = instr.n < 0 ? -instr.n : instr.n;
+
+					while(e) {
+
+						if(e & 1) {
+							const double t = r_re * x_re - r_im * x_im;
+							r_im = r_re * x_im + r_im * x_re;
+							r_re = t;
+						}
+
+						const double t = x_re * x_re - x_im * x_im;
+						x_im = 2 * x_re * x_im;
+						x_re = t;
+						e >>= 1;
+					}
+
+					if(instr.n < 0) {
+						const double m = r_re * r_re + r_im * r_im;
+						r_re = r_re / m;
+						r_im = -r_im / m;
+					}
+
+					d_re[l] = r_re; d_im[l] = r_im;
+				}
+				break;
+
+			case OP_EXP:
+				for (unsigned int l = 0; l < n; ++l) {
+					const double e = std::exp(a_re[l]);
+					const double im = a_im[l];
+					d_re[l] = e * std::cos(im);
+					d_im[l] = e * std::sin(im);
+				}
+				break;
+
+			case OP_LN:
+				for (unsigned int l = 0; l < n; ++l) {
+					const double re = 0.5 * std::log(a_re[l] * a_re[l] + a_im[l] * a_im[l]);
+					const double im = std::atan2(a_im[l], a_re[l]);
+					d_re[l] = re; d_im[l] = im;
+				}
+				break;
+
+			case OP_SIN:
+				// sin(a + ib) = sin(a) cosh(b) + i cos(a) sinh(b)
+				for (unsigned int l = 0; l < n; ++l) {
+					const double re = std::sin(a_re[l]) * std::cosh(a_im[l]);
+					const double im = std::cos(a_re[l]) * std::sinh(a_im[l]);
+					d_re[l] = re; d_im[l] = im;
+				}
+				break;
+
+			case OP_COS:
+				// cos(a + ib) = cos(a) cosh(b) - i sin(a) sinh(b)
+				for (unsigned int l = 0; l < n; ++l) {
+					const double re = std::cos(a_re[l]) * std::cosh(a_im[l]);
+					const double im = -std::sin(a_re[l]) * std::sinh(a_im[l]);
+					d_re[l] = re; d_im[l] = im;
+				}
+				break;
+
+			case OP_TAN:
+				// tan(a + ib) = (sin(2a) + i sinh(2b)) / (cos(2a) + cosh(2b))
+				for (unsigned int l = 0; l < n; ++l) {
+					const double m = std::cos(2 * a_re[l]) + std::cosh(2 * a_im[l]);
+					const double re = std::sin(2 * a_re[l]) / m;
+					const double im = std::sinh(2 * a_im[l]) / m;
+					d_re[l] = re; d_im[l] = im;
+				}
+				break;
+
+			case OP_SQRT:
+				for (unsigned int l = 0; l < n; ++l) {
+					const double m = std::sqrt(a_re[l] * a_re[l] + a_im[l] * a_im[l]);
+					const double re = std::sqrt(0.5 * (m + a_re[l]));
+					const double im = std::copysign(std::sqrt(0.5 * (m - a_re[l])), a_im[l]);
+					d_re[l] = re; d_im[l] = im;
+				}
+				break;
+
+			case OP_POW:
+				// a^b = exp(b ln(a))
+				for (unsigned int l = 0; l < n; ++l) {
+
+					const double m = a_re[l] * a_re[l] + a_im[l] * a_im[l];
+					const double ln_re = 0.5 * std::log(m);
+					const double ln_im = std::atan2(a_im[l], a_re[l]);
+					const double e_re = b_re[l] * ln_re - b_im[l] * ln_im;
+					const double e_im = b_re[l] * ln_im + b_im[l] * ln_re;
+					const double e = m == 0 ? 0 : std::exp(e_re);
+
+					d_re[l] = e * std::cos(e_im);
+					d_im[l] = e * std::sin(e_im);
+				}
+				break;
+		}
+	}
+
+	for (unsigned int l = 0; l < n; ++l) {
+		z_a[l] = RE(result)[l];
+		z_b[l] = IM(result)[l];
+	}
+
+	#undef RE
+	#undef IM
+}
+
+
+std::string giulia::formula::disassemble() const {
+
+	std::stringstream out;
+
+	for (size_t k = 0; k < constants.size(); ++k)
+		out << "r" << (k + 2) << " = const "
+			<< constants[k][0] << " " << constants[k][1] << "\n";
+
+	for (size_t k = 0; k < code.size(); ++k) {
+
+		const formula_instruction& instr = code[k];
+		out << "r" << instr.dst << " = " << op_names[instr.op] << " r" << instr.a;
+
+		if(instr.op == OP_POWI)
+			out << " " << instr.n;
+		else if(instr.op <= OP_DIV || instr.op == OP_POW)
+			out << " r" << instr.b;
+
+		out << "\n";
+	}
+
+	out << "return r" << result << "\n";
+	return out.str();
+}
+
+
+// Gray scale smooth coloring shared by the scalar and batch drawing routines
+static pixel formula_color(unsigned int i, real_t sqr_modulus, real_t R, unsigned int max_iter) {
+
+	// Smooth intensity factor
+	real intensity_factor = (i - ln(0.5 * ln(sqr_modulus) / ln(R)) / LN2) / (real) max_iter;
+	real brightness = 0.04 * max_iter;
+
+	unsigned char res = clamp(255 * brightness * intensity_factor, 0, 255);
+
+	// Gray scale result
+	return pixel(res, res, res);
+}
+
+
+pixel giulia::draw_formula(real_t x, real_t y, const formula& f, real_t R, unsigned int max_iter) {
+
+	if(!f.valid())
+		return pixel(0, 0, 0);
+
+	std::vector<real_t> regs(2 * f.registers());
+
+	real_t z_a = x;
+	real_t z_b = y;
+
+	// Number of iterations
+	unsigned int i = 0;
+
+	while((z_a * z_a + z_b * z_b) < (R * R) && i <= max_iter) {
+		f.eval(z_a, z_b, x, y, &regs[0]);
+		i++;
+	}
+
+	return formula_color(i, z_a * z_a + z_b * z_b, R, max_iter);
+}
+
+
+void giulia::draw_formula(
+	const real_t* x, const real_t* y, pixel* out, unsigned int n,
+	const formula& f, real_t R, unsigned int max_iter) {
+
+	const unsigned int B = formula::batch_size;
+
+	if(!f.valid()) {
+		for (unsigned int i = 0; i < n; ++i)
+			out[i] = pixel(0, 0, 0);
+		return;
+	}
+
+	std::vector<double> regs(2 * f.registers() * B);
+	const double R2 = R * R;
+
+	double z_a[B], z_b[B], c_a[B], c_b[B];
+	double w_a[B], w_b[B];
+	unsigned int iter[B];
+
+	for (unsigned int base = 0; base < n; base += B) {
+
+		const unsigned int m = (n - base) < B ? (n - base) : B;
+
+		for (unsigned int l = 0; l < m; ++l) {
+			z_a[l] = c_a[l] = x[base + l];
+			z_b[l] = c_b[l] = y[base + l];
+			iter[l] = 0;
+		}
+
+		for (unsigned int i = 0; i <= max_iter; ++i) {
+
+			bool any = false;
+
+			for (unsigned int l = 0; l < m; ++l) {
+				w_a[l] = z_a[l];
+				w_b[l] = z_b[l];
+			}
+
+			f.eval(w_a, w_b, c_a, c_b, m, &regs[0]);
+
+			// Only advance the lanes which have not escaped yet
+			for (unsigned int l = 0; l < m; ++l) {
+
+				const bool active = (z_a[l] * z_a[l] + z_b[l] * z_b[l]) < R2 && iter[l] == i;
+
+				z_a[l] = active ? w_a[l] : z_a[l];
+				z_b[l] = active ? w_b[l] : z_b[l];
+				iter[l] += active;
+				any = any || active;
+			}
+
+			if(!any)
+				break;
+		}
+
+		for (unsigned int l = 0; l < m; ++l)
+			out[base + l] = formula_color(
+				iter[l], z_a[l] * z_a[l] + z_b[l] * z_b[l], R, max_iter);
+	}
+}
@@ -1,91 +1,125 @@
 #include "fractals.h"
+#include "simd.h"
+#include "orbit_trap.h"
+#include "flame.h"
 
 #define THEORETICA_LONG_DOUBLE_PREC
 #include "theoretica/theoretica.h"
 
 using namespace theoretica;
 using namespace giulia;
+namespace th = theoretica;
 
 #include <ctime>
+#include <cmath>
+#include <algorithm>
 
 
-pixel giulia::draw_giulia_present(real_t x, real_t y, unsigned int max_iter) {
+// Smooth iteration count of an orbit escaping radius <R> after <i> iterations
+static inline real smooth_iter(unsigned int i, real sqr_modulus, real R) {
+	return i - ln(0.5 * ln(sqr_modulus) / ln(R)) / LN2;
+}
 
-	complex z = complex(x, y);
-	complex d = z;
-	complex c = complex(-0.76, 0.1482);
 
-	// Escape radius
-	real R = 2;
+// Exterior distance estimate of a quadratic orbit which escaped at <z> with
+// derivative <dz>, iterated a few more times since the estimate is only
+// accurate for large moduli. The derivative with respect to the parameter
+// gains 1 each step for the Mandelbrot set, and nothing for Julia sets.
+static inline real distance_estimate(complex z, complex dz, complex c, real dc) {
 
-	// Number of iterations
-	unsigned int i = 0;
+	for (int k = 0; k < 8 && z.square_modulus() < 1E+10; ++k) {
+		dz = 2 * z * dz + complex(dc, 0);
+		z = square(z) + c;
+	}
 
-	// Orbit trap minimum distances
-	real dist1 = R;
-	real dist2 = R;
-	real dist3 = R;
-	real dist4 = R;
+	const real dz_modulus = dz.modulus();
+
+	if(dz_modulus <= 0)
+		return 0;
+
+	const real z_modulus = z.modulus();
+	return 0.5 * z_modulus * ln(z_modulus) / dz_modulus;
+}
+
+
+field_sample giulia::sample_giulia_present(real_t x, real_t y, unsigned int max_iter) {
 
 	// Orbit trap positions
-	complex trap1 = complex(0, 0);
-	complex trap2 = complex(0.1, 0.1);
-	complex trap3 = complex(0.2, 0.2);
-	complex trap4 = complex(0.3, 0.3);
+	static const orbit_trap_engine traps = orbit_trap_engine({
+		orbit_trap::point(0, 0),
+		orbit_trap::point(0.1, 0.1),
+		orbit_trap::point(0.2, 0.2),
+		orbit_trap::point(0.3, 0.3)
+	}, 2);
 
-	while(z.square_modulus() < (R * R) && i <= max_iter) {
+	// Escape radius
+	real R = traps.radius();
 
-		// z_i+1 = z_i ^ 2 + c
-		z = square(z) + c;
+	field_sample s;
+	real_t z_a = x;
+	real_t z_b = y;
 
-		dist1 = min(dist1, (z - trap1).modulus());
-		dist2 = min(dist2, (z - trap2).modulus());
-		dist3 = min(dist3, (z - trap3).modulus());
-		dist4 = min(dist4, (z - trap4).modulus());
+	// Number of iterations and orbit trap minimum distances
+	unsigned int i = traps.iterate(z_a, z_b, -0.76, 0.1482, s.trap, max_iter, R);
 
-		i++;
-	}
+	s.iter = smooth_iter(i, z_a * z_a + z_b * z_b, R);
+	s.modulus = th::sqrt(z_a * z_a + z_b * z_b);
 
-	// Normalized iteration factor
-	real iter_factor = i / (real) max_iter;
+	return s;
+}
 
-	// Smooth intensity factor
-	real intensity_factor = (i - ln(0.5 * ln(z.square_modulus()) / ln(R)) / LN2) / (real) max_iter;
+
+pixel giulia::shade_giulia_present(const field_sample& s, real_t x, real_t y, unsigned int max_iter) {
 
 	// Base and trap colors
-	vec3 base_color = {0x9b, 0x5d, 0xe5};
-	vec3 trap_color1 = {0xf1, 0x5b, 0xb5};
-	vec3 trap_color2 = {0xfe, 0x00, 0x40};
-	vec3 trap_color3 = {0x0f, 0xbb, 0xb9};
-	vec3 trap_color4 = {0xff, 0x00, 0x6e};
+	static const float base_color[3] = {0x9b, 0x5d, 0xe5};
+	static const float trap_color1[3] = {0xf1, 0x5b, 0xb5};
+	static const float trap_color2[3] = {0xfe, 0x00, 0x40};
+	static const float trap_color4[3] = {0xff, 0x00, 0x6e};
 
-	// Pixel color
-	vec3 color = lerp(base_color, trap_color1, dist1);
-	color = lerp(color, trap_color2, dist2);
-	color = lerp(color, trap_color4, dist4);
+	const float dist1 = s.trap[0];
+	const float dist2 = s.trap[1];
+	const float dist4 = s.trap[3];
+
+	// Smooth intensity factor
+	const float intensity_factor = s.iter / (real) max_iter;
 
-	color *= intensity_factor;
+	// Gaussian vignette, with a single exponential
+	const float vignette = std::exp(-(float) (square(x) / 4 + square(y)));
 
-	real x_factor = exp(-square(x) / 4);
-	real y_factor = exp(-square(y) / 1);
+	const float brightness = 80;
+	const float k = intensity_factor * vignette * brightness;
 
-	color *= x_factor * y_factor;
+	// Pixel color
+	float color[3];
 
-	real brightness = 80;
+	for (int i = 0; i < 3; ++i) {
+		float c = base_color[i] + (trap_color1[i] - base_color[i]) * dist1;
+		c += (trap_color2[i] - c) * dist2;
+		c += (trap_color4[i] - c) * dist4;
+		color[i] = c * k;
+	}
 
 	return pixel(
-		clamp(color[0] * brightness, 0, 255),
-		clamp(color[1] * brightness, 0, 255),
-		clamp(color[2] * brightness, 0, 255));
+		clamp(color[0], 0, 255),
+		clamp(color[1], 0, 255),
+		clamp(color[2], 0, 255));
 }
 
 
-pixel giulia::draw_julia(real_t x, real_t y, real_t c_x, real_t c_y, unsigned int max_iter) {
+pixel giulia::draw_giulia_present(real_t x, real_t y, unsigned int max_iter) {
+	return shade_giulia_present(sample_giulia_present(x, y, max_iter), x, y, max_iter);
+}
+
+
+field_sample giulia::sample_julia(real_t x, real_t y, real_t c_x, real_t c_y, unsigned int max_iter) {
 
 	complex z = complex(x, y);
-	complex d = z;
 	complex c = complex(c_x, c_y);
 
+	// Derivative of the orbit with respect to the starting point
+	complex dz = complex(1, 0);
+
 	// Escape radius
 	real R = 2;
 
@@ -94,30 +128,35 @@ pixel giulia::draw_julia(real_t x, real_t y, real_t c_x, real_t c_y, unsigned in
 
 	while(z.square_modulus() < (R * R) && i <= max_iter) {
 		// z_i+1 = z_i ^ 2 + c
+		dz = 2 * z * dz;
 		z = square(z) + c;
 		i++;
 	}
 
-	// Normalized iteration factor
-	real iter_factor = i / (real) max_iter;
+	field_sample s;
+	s.iter = smooth_iter(i, z.square_modulus(), R);
+	s.modulus = z.modulus();
 
-	// Smooth intensity factor
-	real intensity_factor = (i - ln(0.5 * ln(z.square_modulus()) / ln(R)) / LN2) / (real) max_iter;
+	if(z.square_modulus() >= (R * R))
+		s.distance = distance_estimate(z, dz, c, 0);
 
-	real brightness = 0.005 * max_iter;
+	return s;
+}
 
-	// Resulting gray scale color
-	real gray_scale = clamp(255 * intensity_factor * brightness, 0, 255);
 
-	return pixel(gray_scale, gray_scale, gray_scale);
+pixel giulia::draw_julia(real_t x, real_t y, real_t c_x, real_t c_y, unsigned int max_iter) {
+	return shade_gray(sample_julia(x, y, c_x, c_y, max_iter), max_iter, 0.005 * max_iter);
 }
 
 
-pixel giulia::draw_mandelbrot(real_t x, real_t y, unsigned int max_iter) {
+field_sample giulia::sample_mandelbrot(real_t x, real_t y, unsigned int max_iter) {
 
 	complex z = complex(x, y);
 	complex c = complex(x, y);
 
+	// Derivative of the orbit with respect to the parameter
+	complex dz = complex(1, 0);
+
 	// Escape radius
 	real R = 2;
 
@@ -125,25 +164,28 @@ pixel giulia::draw_mandelbrot(real_t x, real_t y, unsigned int max_iter) {
 	unsigned int i = 0;
 
 	while(z.square_modulus() < (R * R) && i <= max_iter) {
+		dz = 2 * z * dz + complex(1, 0);
 		z = square(z) + c;
 		i++;
 	}
 
-	// Normalized iteration factor
-	real iter_factor = i / (real) max_iter;
+	field_sample s;
+	s.iter = smooth_iter(i, z.square_modulus(), R);
+	s.modulus = z.modulus();
 
-	// Smooth intensity factor
-	real intensity_factor = (i - ln(0.5 * ln(z.square_modulus()) / ln(R)) / LN2) / (real) max_iter;
-	real brightness = 0.04 * max_iter;
+	if(z.square_modulus() >= (R * R))
+		s.distance = distance_estimate(z, dz, c, 1);
 
-	unsigned char res = clamp(255 * brightness * intensity_factor, 0, 255);
+	return s;
+}
 
-	// Gray scale result
-	return pixel(res, res, res);
+
+pixel giulia::draw_mandelbrot(real_t x, real_t y, unsigned int max_iter) {
+	return shade_gray(sample_mandelbrot(x, y, max_iter), max_iter, 0.04 * max_iter);
 }
 
 
-pixel giulia::draw_mandelbar(real_t x, real_t y, unsigned int max_iter) {
+field_sample giulia::sample_mandelbar(real_t x, real_t y, unsigned int max_iter) {
 
 	complex z = complex(x, y);
 	complex c = complex(x, y);
@@ -159,22 +201,20 @@ pixel giulia::draw_mandelbar(real_t x, real_t y, unsigned int max_iter) {
 		i++;
 	}
 
-	// Normalized iteration factor
-	real iter_factor = i / (real) max_iter;
+	field_sample s;
+	s.iter = smooth_iter(i, z.square_modulus(), R);
+	s.modulus = z.modulus();
 
-	// Smooth intensity factor
-	real intensity_factor = (i - ln(0.5 * ln(z.square_modulus()) / ln(R)) / LN2) / (real) max_iter;
-	real brightness = 0.04 * max_iter;
-
-	unsigned char res = clamp(255 * brightness * intensity_factor, 0, 255);
+	return s;
+}
 
-	// Gray scale result
-	return pixel(res, res, res);
 
+pixel giulia::draw_mandelbar(real_t x, real_t y, unsigned int max_iter) {
+	return shade_gray(sample_mandelbar(x, y, max_iter), max_iter, 0.04 * max_iter);
 }
 
 
-pixel giulia::draw_fractal(real_t x, real_t y, fractal_map f, real_t R, unsigned int max_iter) {
+field_sample giulia::sample_fractal(real_t x, real_t y, fractal_map f, real_t R, unsigned int max_iter) {
 
 	real_t z_a = x;
 	real_t z_b = y;
@@ -189,18 +229,145 @@ pixel giulia::draw_fractal(real_t x, real_t y, fractal_map f, real_t R, unsigned
 		i++;
 	}
 
-	// Normalized iteration factor
-	real iter_factor = i / (real) max_iter;
+	field_sample s;
+	s.iter = smooth_iter(i, z_a * z_a + z_b * z_b, R);
+	s.modulus = th::sqrt(z_a * z_a + z_b * z_b);
+
+	return s;
+}
+
+
+pixel giulia::draw_fractal(real_t x, real_t y, fractal_map f, real_t R, unsigned int max_iter) {
+	return shade_gray(sample_fractal(x, y, f, R, max_iter), max_iter, 0.04 * max_iter);
+}
+
+
+pixel giulia::shade_gray(const field_sample& s, unsigned int max_iter, real_t brightness) {
 
 	// Smooth intensity factor
-	real intensity_factor = (i - ln(0.5 * ln(z_a * z_a + z_b * z_b) / ln(R)) / LN2) / (real) max_iter;
-	real brightness = 0.04 * max_iter;
+	real intensity_factor = s.iter / (real) max_iter;
 
 	unsigned char res = clamp(255 * brightness * intensity_factor, 0, 255);
 
 	// Gray scale result
 	return pixel(res, res, res);
+}
+
+
+pixel giulia::shade_distance(
+	const field_sample& s, real_t pixel_size, unsigned int max_iter, real_t brightness) {
+
+	// Smooth intensity factor
+	real intensity_factor = s.iter / (real) max_iter;
+
+	const float exterior = clamp(255 * brightness * intensity_factor, 0, 255);
+	const float boundary = clamp(255 * brightness, 0, 255);
+
+	// Points inside the set have no distance estimate
+	if(s.distance <= 0 || pixel_size <= 0)
+		return pixel(exterior, exterior, exterior);
+
+	// Coverage of the pixel footprint by the exterior, smoothed at the boundary
+	float t = clamp(s.distance / pixel_size, 0, 1);
+	t = t * t * (3 - 2 * t);
+
+	const unsigned char res = boundary + (exterior - boundary) * t;
+	return pixel(res, res, res);
+}
+
+
+// Iterate the quadratic map over a rectangle of starting points <z> and
+// parameters <c>, until all of its orbits escape together or some of
+// them escape while others do not
+static bool bound_escape(
+	complex_interval z, complex_interval c, unsigned int max_iter,
+	real& iter_min, real& iter_max) {
+
+	// Escape radius
+	real R = 2;
+
+	for (unsigned int i = 0; i <= max_iter + 1; ++i) {
+
+		const interval m = z.square_modulus();
+
+		// Every orbit escaped at the same iteration, and the smooth
+		// iteration count decreases with the modulus at escape
+		if(m.lo >= R * R) {
+			iter_min = smooth_iter(i, m.hi, R);
+			iter_max = smooth_iter(i, m.lo, R);
+			return true;
+		}
+
+		// Some orbits escaped and others did not
+		if(m.hi >= R * R)
+			return false;
+
+		z = square(z) + c;
+	}
+
+	return false;
+}
+
+
+bool giulia::bound_mandelbrot(
+	real_t x_min, real_t y_min, real_t x_max, real_t y_max,
+	real_t& iter_min, real_t& iter_max, unsigned int max_iter) {
+
+	const complex_interval c = complex_interval(interval(x_min, x_max), interval(y_min, y_max));
+	return bound_escape(c, c, max_iter, iter_min, iter_max);
+}
+
+
+bool giulia::bound_julia(
+	real_t x_min, real_t y_min, real_t x_max, real_t y_max,
+	real_t& iter_min, real_t& iter_max,
+	real_t c_x, real_t c_y, unsigned int max_iter) {
+
+	const complex_interval z = complex_interval(interval(x_min, x_max), interval(y_min, y_max));
+	return bound_escape(z, complex(c_x, c_y), max_iter, iter_min, iter_max);
+}
+
+
+// Whether gray scale shading gives the same color at both ends of a range
+// of smooth iteration counts, and so over all of it since it is monotonic
+static bool uniform_gray(
+	real_t iter_min, real_t iter_max, unsigned int max_iter,
+	real_t brightness, pixel& fill) {
+
+	field_sample s_min, s_max;
+	s_min.iter = iter_min;
+	s_max.iter = iter_max;
+
+	fill = shade_gray(s_min, max_iter, brightness);
+	const pixel p = shade_gray(s_max, max_iter, brightness);
+
+	return p.r == fill.r && p.g == fill.g && p.b == fill.b;
+}
+
+
+bool giulia::cull_mandelbrot(
+	real_t x_min, real_t y_min, real_t x_max, real_t y_max,
+	pixel& fill, unsigned int max_iter) {
+
+	real_t iter_min, iter_max;
 
+	if(!bound_mandelbrot(x_min, y_min, x_max, y_max, iter_min, iter_max, max_iter))
+		return false;
+
+	return uniform_gray(iter_min, iter_max, max_iter, 0.04 * max_iter, fill);
+}
+
+
+bool giulia::cull_julia(
+	real_t x_min, real_t y_min, real_t x_max, real_t y_max, pixel& fill,
+	real_t c_x, real_t c_y, unsigned int max_iter) {
+
+	real_t iter_min, iter_max;
+
+	if(!bound_julia(x_min, y_min, x_max, y_max, iter_min, iter_max, c_x, c_y, max_iter))
+		return false;
+
+	return uniform_gray(iter_min, iter_max, max_iter, 0.005 * max_iter, fill);
 }
 
 
@@ -233,48 +400,419 @@ void giulia::draw_sierpinski_triangle(
 }
 
 
-pixel giulia::draw_newton_fractal(real_t x, real_t y,
+void giulia::draw_sierpinski_flame(
+	image& img, real_t x, real_t y, real_t width, unsigned int iter, pixel c) {
+
+	if(width == 0) {
+		width = 0.8;
+		x = 0.1;
+		y = 0.5 - SQRT2 * 0.2;
+	}
+
+	vec2 A[3];
+	A[0] = {x, y};
+	A[1] = {x + width, y};
+	A[2] = {x + width / 2.0, y + (width * SQRT2 / 2.0)};
+
+	// Chaos game over the normalized coordinates of the image
+	flame f = flame(img.get_width(), img.get_height(), 0, 0, 1, 1);
+
+	// P = (P + A_k) / 2
+	for (int k = 0; k < 3; ++k)
+		f.add_transform(flame_transform(0.5, 0, A[k][0] / 2.0, 0, 0.5, A[k][1] / 2.0, 1, VAR_LINEAR, c));
+
+	f.render(iter, time(nullptr));
+	f.draw(img);
+}
+
+
+giulia::newton_fractal::newton_fractal(
 	const std::vector<std::array<real_t, 2>>& roots,
-	const std::vector<pixel>& colors, unsigned int max_iter, real_t epsilon) {
+	const std::vector<pixel>& colors, unsigned int max_iter, real_t epsilon)
+	: colors(colors), max_iter(max_iter), epsilon(epsilon) {
 
 	if(roots.size() != colors.size())
-		return pixel(0, 0, 0);
+		return;
 
-	std::vector<complex> complex_roots;
-	complex_roots.reserve(roots.size());
+	roots_re.reserve(roots.size());
+	roots_im.reserve(roots.size());
 
-	for (size_t i = 0; i < roots.size(); ++i)
-		complex_roots.emplace_back(roots[i][0], roots[i][1]);
+	for (size_t i = 0; i < roots.size(); ++i) {
+		roots_re.push_back(roots[i][0]);
+		roots_im.push_back(roots[i][1]);
+	}
 
+	// Expand the product of (z - r_k) into coefficients,
+	// from the highest degree to the constant term
+	coeff_re.assign(1, 1);
+	coeff_im.assign(1, 0);
 
-	polynomial<complex> P = polynomial<complex>::from_roots(complex_roots);
-	polynomial<complex> dP = deriv_polynomial(P);
+	for (size_t k = 0; k < roots.size(); ++k) {
 
-	complex z = complex(x, y);
-	pixel c = pixel(0, 0, 0);
-	unsigned int iter = 0;
-	real dist = inf();
+		coeff_re.push_back(0);
+		coeff_im.push_back(0);
 
-	// Newton's method in the complex plane
-	while(dist > epsilon && iter < max_iter) {
-		z = z - (P(z) / dP(z));
-		dist = P(z).modulus();
-		iter++;
+		for (size_t j = coeff_re.size() - 1; j > 0; --j) {
+			coeff_re[j] -= coeff_re[j - 1] * roots_re[k] - coeff_im[j - 1] * roots_im[k];
+			coeff_im[j] -= coeff_re[j - 1] * roots_im[k] + coeff_im[j - 1] * roots_re[k];
+		}
 	}
+}
+
 
+unsigned int giulia::newton_fractal::degree() const {
+	return roots_re.size();
+}
+
+
+pixel giulia::newton_fractal::shade(unsigned int root, unsigned int iter) const {
+
+	pixel c = colors[root];
+	real intensity_factor = 1 - (iter / (real) max_iter);
+	return c * intensity_factor;
+}
+
+
+unsigned int giulia::newton_fractal::nearest_root(real_t z_a, real_t z_b) const {
+
+	unsigned int root = 0;
 	real pick_dist = inf();
 
-	// Find the nearest root
-	for (size_t i = 0; i < complex_roots.size(); ++i) {
+	for (size_t k = 0; k < roots_re.size(); ++k) {
 
-		const real curr_dist = (z - complex_roots[i]).modulus();
+		const real curr_dist = square(z_a - roots_re[k]) + square(z_b - roots_im[k]);
 
 		if(curr_dist < pick_dist) {
 			pick_dist = curr_dist;
-			c = colors[i];
+			root = k;
 		}
 	}
 
-	real intensity_factor = 1 - (iter / (real) max_iter);
-	return c * intensity_factor;
+	return root;
+}
+
+
+pixel giulia::newton_fractal::operator()(real_t x, real_t y) const {
+
+	const unsigned int n = roots_re.size();
+
+	if(!n)
+		return pixel(0, 0, 0);
+
+	const real eps2 = epsilon * epsilon;
+
+	real z_a = x;
+	real z_b = y;
+	unsigned int iter = 0;
+
+	// Newton's method in the complex plane
+	while(iter < max_iter) {
+
+		// Fused Horner evaluation of P(z) and P'(z)
+		real p_a = coeff_re[0];
+		real p_b = coeff_im[0];
+		real dp_a = 0;
+		real dp_b = 0;
+
+		for (unsigned int k = 1; k <= n; ++k) {
+
+			const real dp_tmp = dp_a * z_a - dp_b * z_b + p_a;
+			dp_b = dp_a * z_b + dp_b * z_a + p_b;
+			dp_a = dp_tmp;
+
+			const real p_tmp = p_a * z_a - p_b * z_b + coeff_re[k];
+			p_b = p_a * z_b + p_b * z_a + coeff_im[k];
+			p_a = p_tmp;
+		}
+
+		// Converged on the previous step
+		if(iter && (p_a * p_a + p_b * p_b) <= eps2)
+			break;
+
+		const real dp_sqr = dp_a * dp_a + dp_b * dp_b;
+
+		if(dp_sqr == 0)
+			break;
+
+		// z = z - P(z) / P'(z)
+		z_a -= (p_a * dp_a + p_b * dp_b) / dp_sqr;
+		z_b -= (p_b * dp_a - p_a * dp_b) / dp_sqr;
+		iter++;
+
+		// Early exit as soon as a root is reached
+		for (unsigned int k = 0; k < n; ++k)
+			if((square(z_a - roots_re[k]) + square(z_b - roots_im[k])) <= eps2)
+				return shade(k, iter);
+	}
+
+	return shade(nearest_root(z_a, z_b), iter);
+}
+
+
+void giulia::newton_fractal::draw(const real_t* x, const real_t* y, pixel* out, unsigned int n) const {
+
+	const unsigned int W = simd_real::width;
+	const unsigned int deg = roots_re.size();
+
+	if(!deg) {
+		for (unsigned int i = 0; i < n; ++i)
+			out[i] = pixel(0, 0, 0);
+		return;
+	}
+
+	const double eps2 = epsilon * epsilon;
+	unsigned int i = 0;
+
+	for (; i + W <= n; i += W) {
+
+		simd_real z_a, z_b;
+		simd_real iter = 0;
+		simd_real root = -1;
+		simd_bool active = simd_bool(true);
+
+		for (unsigned int l = 0; l < W; ++l) {
+			z_a[l] = x[i + l];
+			z_b[l] = y[i + l];
+		}
+
+		for (unsigned int it = 0; it < max_iter && active.any(); ++it) {
+
+			// Fused Horner evaluation of P(z) and P'(z) over all lanes
+			simd_real p_a = (double) coeff_re[0];
+			simd_real p_b = (double) coeff_im[0];
+			simd_real dp_a = 0.0;
+			simd_real dp_b = 0.0;
+
+			for (unsigned int k = 1; k <= deg; ++k) {
+
+				const simd_real dp_tmp = dp_a * z_a - dp_b * z_b + p_a;
+				dp_b = dp_a * z_b + dp_b * z_a + p_b;
+				dp_a = dp_tmp;
+
+				const simd_real p_tmp = p_a * z_a - p_b * z_b + (double) coeff_re[k];
+				p_b = p_a * z_b + p_b * z_a + (double) coeff_im[k];
+				p_a = p_tmp;
+			}
+
+			const simd_real dp_sqr = dp_a * dp_a + dp_b * dp_b;
+
+			if(it)
+				active = active & (p_a * p_a + p_b * p_b > eps2);
+
+			active = active & (dp_sqr > 0.0);
+
+			const simd_real safe_dp = simd::select(active, dp_sqr, simd_real(1.0));
+			z_a = simd::select(active, z_a - (p_a * dp_a + p_b * dp_b) / safe_dp, z_a);
+			z_b = simd::select(active, z_b - (p_b * dp_a - p_a * dp_b) / safe_dp, z_b);
+			iter = simd::select(active, iter + 1.0, iter);
+
+			// Early exit of lanes which reached a root
+			for (unsigned int k = 0; k < deg; ++k) {
+
+				const simd_real d_a = z_a - (double) roots_re[k];
+				const simd_real d_b = z_b - (double) roots_im[k];
+				const simd_bool hit = active & (d_a * d_a + d_b * d_b <= eps2);
+
+				root = simd::select(hit, simd_real((double) k), root);
+				active = active & !hit;
+			}
+		}
+
+		for (unsigned int l = 0; l < W; ++l) {
+
+			const unsigned int k = root[l] >= 0
+				? (unsigned int) root[l]
+				: nearest_root(z_a[l], z_b[l]);
+
+			out[i + l] = shade(k, iter[l]);
+		}
+	}
+
+	// Remaining pixels
+	for (; i < n; ++i)
+		out[i] = (*this)(x[i], y[i]);
+}
+
+
+pixel giulia::draw_newton_fractal(real_t x, real_t y,
+	const std::vector<std::array<real_t, 2>>& roots,
+	const std::vector<pixel>& colors, unsigned int max_iter, real_t epsilon) {
+
+	return newton_fractal(roots, colors, max_iter, epsilon)(x, y);
+}
+
+
+// Number of derivatives of the logistic map multiplied together before taking
+// a single logarithm, which stays within double range for r in [0, 4]
+static const unsigned int lyapunov_group = 8;
+
+// Number of iterations between checks of the Lyapunov exponent estimate
+static const unsigned int lyapunov_check = 16 * lyapunov_group;
+
+
+giulia::lyapunov_fractal::lyapunov_fractal(
+	const std::string& sequence, unsigned int max_iter,
+	unsigned int warmup, real_t tolerance)
+	: max_iter(max_iter), warmup(warmup), tolerance(tolerance) {
+
+	for (size_t i = 0; i < sequence.size(); ++i) {
+
+		if(sequence[i] == 'A' || sequence[i] == 'a')
+			this->sequence.push_back(false);
+		else if(sequence[i] == 'B' || sequence[i] == 'b')
+			this->sequence.push_back(true);
+	}
+
+	if(this->sequence.empty())
+		this->sequence = {false, true};
+}
+
+
+void giulia::lyapunov_fractal::exponents(
+	const real_t* a, const real_t* b, real_t* out, unsigned int n) const {
+
+	const unsigned int W = simd_real::width;
+	const unsigned int length = sequence.size();
+	const unsigned int group = lyapunov_group;
+	const unsigned int check = lyapunov_check;
+
+	for (unsigned int i = 0; i < n; i += W) {
+
+		// Lanes past the end repeat the last parameter pair
+		simd_real r_a, r_b;
+
+		for (unsigned int l = 0; l < W; ++l) {
+			const unsigned int k = (i + l < n) ? i + l : n - 1;
+			r_a[l] = a[k];
+			r_b[l] = b[k];
+		}
+
+		simd_real x = 0.5;
+		unsigned int step = 0;
+
+		// Skip the transient of the orbit
+		for (unsigned int k = 0; k < warmup; ++k) {
+
+			const simd_real& r = sequence[step] ? r_b : r_a;
+			x = r * x * (1.0 - x);
+			step = (step + 1 == length) ? 0 : step + 1;
+		}
+
+		simd_real sum = 0.0;
+		simd_real estimate = 0.0;
+		simd_real result = 0.0;
+		simd_bool active = simd_bool(true);
+		unsigned int count = 0;
+
+		while(count < max_iter && active.any()) {
+
+			// Product of |f'(x)| = |r (1 - 2x)| along the orbit
+			simd_real prod = 1.0;
+
+			for (unsigned int k = 0; k < group; ++k) {
+
+				const simd_real& r = sequence[step] ? r_b : r_a;
+				prod *= simd::abs(r * (1.0 - 2.0 * x));
+				x = r * x * (1.0 - x);
+				step = (step + 1 == length) ? 0 : step + 1;
+			}
+
+			sum += simd::log(simd::max(prod, simd_real(1E-300)));
+			count += group;
+
+			// Freeze the lanes whose estimate stabilized
+			if(count % check == 0) {
+
+				const simd_real next = sum / (double) count;
+				result = simd::select(active, next, result);
+				active = active & (simd::abs(next - estimate) >= simd_real((double) tolerance));
+				estimate = next;
+			}
+		}
+
+		if(count)
+			result = simd::select(active, sum / (double) count, result);
+
+		for (unsigned int l = 0; l < W && i + l < n; ++l)
+			out[i + l] = result[l];
+	}
+}
+
+
+pixel giulia::lyapunov_fractal::shade(real_t exponent) {
+
+	if(!(exponent == exponent))
+		return pixel(0, 0, 0);
+
+	// Stable orbits
+	if(exponent <= 0) {
+		const real intensity_factor = 1 - std::exp((double) exponent);
+		return pixel(255 * intensity_factor, 214 * intensity_factor, 0);
+	}
+
+	// Chaotic orbits
+	const real intensity_factor = 1 - std::exp((double) -exponent);
+	return pixel(0, 40 * intensity_factor, 160 * intensity_factor);
+}
+
+
+pixel giulia::lyapunov_fractal::operator()(real_t a, real_t b) const {
+
+	// A single orbit, with the same arithmetic as a lane of exponents()
+	const unsigned int length = sequence.size();
+	const double r_a = a;
+	const double r_b = b;
+
+	double x = 0.5;
+	unsigned int step = 0;
+
+	for (unsigned int k = 0; k < warmup; ++k) {
+
+		const double r = sequence[step] ? r_b : r_a;
+		x = r * x * (1.0 - x);
+		step = (step + 1 == length) ? 0 : step + 1;
+	}
+
+	double sum = 0;
+	double estimate = 0;
+	unsigned int count = 0;
+
+	while(count < max_iter) {
+
+		double prod = 1.0;
+
+		for (unsigned int k = 0; k < lyapunov_group; ++k) {
+
+			const double r = sequence[step] ? r_b : r_a;
+			prod *= std::abs(r * (1.0 - 2.0 * x));
+			x = r * x * (1.0 - x);
+			step = (step + 1 == length) ? 0 : step + 1;
+		}
+
+		sum += std::log(std::max(prod, 1E-300));
+		count += lyapunov_group;
+
+		if(count % lyapunov_check == 0) {
+
+			const double next = sum / count;
+
+			if(std::abs(next - estimate) < (double) tolerance)
+				return shade(next);
+
+			estimate = next;
+		}
+	}
+
+	return shade(count ? sum / count : 0);
+}
+
+
+void giulia::lyapunov_fractal::draw(
+	const real_t* a, const real_t* b, pixel* out, unsigned int n) const {
+
+	std::vector<real_t> exps(n);
+	exponents(a, b, exps.data(), n);
+
+	for (unsigned int i = 0; i < n; ++i)
+		out[i] = shade(exps[i]);
 }
@@ -0,0 +1,188 @@
+#include "gbuffer.h"
+
+#include <cmath>
+#include <vector>
+
+using namespace giulia;
+
+
+giulia::geometry_buffer::geometry_buffer(unsigned int w, unsigned int h)
+	: width(w), height(h) {
+
+	depth.resize(w * h, theoretica::inf());
+	normal_x.resize(w * h);
+	normal_y.resize(w * h);
+	normal_z.resize(w * h);
+	material.resize(w * h);
+	steps.resize(w * h);
+	color_r.resize(w * h);
+	color_g.resize(w * h);
+	color_b.resize(w * h);
+}
+
+
+gbuffer_sample giulia::geometry_buffer::get_sample(unsigned int i) const {
+
+	gbuffer_sample s;
+	s.depth = depth[i];
+	s.normal = vec3({normal_x[i], normal_y[i], normal_z[i]});
+	s.material = material[i];
+	s.steps = steps[i];
+	s.color = pixel(color_r[i], color_g[i], color_b[i]);
+
+	return s;
+}
+
+
+void giulia::geometry_buffer::set_sample(unsigned int i, const gbuffer_sample& s) {
+
+	depth[i] = s.depth;
+	normal_x[i] = s.normal.get(0);
+	normal_y[i] = s.normal.get(1);
+	normal_z[i] = s.normal.get(2);
+	material[i] = s.material;
+	steps[i] = s.steps;
+	color_r[i] = s.color.r;
+	color_g[i] = s.color.g;
+	color_b[i] = s.color.b;
+}
+
+
+unsigned int giulia::geometry_buffer::get_width() const {
+	return width;
+}
+
+
+unsigned int giulia::geometry_buffer::get_height() const {
+	return height;
+}
+
+
+unsigned int giulia::geometry_buffer::get_size() const {
+	return width * height;
+}
+
+
+const float* giulia::geometry_buffer::get_depth() const {
+	return depth.data();
+}
+
+
+void giulia::geometry_buffer::shade(image& img, const gbuffer_shading& shading) const {
+
+	if(img.get_width() != width || img.get_height() != height)
+		return;
+
+	// Unit directions and colors of the lights, scaled by their intensity
+	const unsigned int n_lights = shading.lights.size();
+	std::vector<float> light(n_lights * 6);
+
+	for (unsigned int k = 0; k < n_lights; ++k) {
+
+		const gbuffer_light& l = shading.lights[k];
+		const vec3 dir = l.direction.normalized();
+
+		light[k * 6 + 0] = dir.get(0);
+		light[k * 6 + 1] = dir.get(1);
+		light[k * 6 + 2] = dir.get(2);
+		light[k * 6 + 3] = l.color.r / 255.0 * l.intensity;
+		light[k * 6 + 4] = l.color.g / 255.0 * l.intensity;
+		light[k * 6 + 5] = l.color.b / 255.0 * l.intensity;
+	}
+
+	const float inv_steps = shading.max_steps ? 1.0 / shading.max_steps : 0;
+	const float ambient = shading.ambient;
+	const float density = shading.fog_density;
+	const float fog[3] = {
+		(float) shading.fog_color.r,
+		(float) shading.fog_color.g,
+		(float) shading.fog_color.b
+	};
+
+	pixel* out = img.get_data();
+
+	// Rows are shaded in parallel, and pixels in a row run
+	// over contiguous planes with the same arithmetic
+#ifdef GIULIA_USE_OPENMP
+#pragma omp parallel for
+#endif
+	for (int j = 0; j < (int) height; ++j) {
+
+		for (unsigned int i = j * width; i < (j + 1) * width; ++i) {
+
+			if(!(depth[i] < theoretica::inf())) {
+				out[i] = shading.background;
+				continue;
+			}
+
+			// Simple ambient occlusion
+			float occlusion = 1;
+
+			if(shading.occlusion) {
+				occlusion = 1 - steps[i] * inv_steps;
+				occlusion *= occlusion;
+			}
+
+			// Diffuse light of each light
+			float lr = ambient, lg = ambient, lb = ambient;
+
+			for (unsigned int k = 0; k < n_lights; ++k) {
+
+				const float* l = &light[k * 6];
+				float cosine = normal_x[i] * l[0] + normal_y[i] * l[1] + normal_z[i] * l[2];
+				cosine = cosine > 0 ? cosine : 0;
+
+				lr += cosine * l[3];
+				lg += cosine * l[4];
+				lb += cosine * l[5];
+			}
+
+			float r = color_r[i] * occlusion * lr;
+			float g = color_g[i] * occlusion * lg;
+			float b = color_b[i] * occlusion * lb;
+
+			// Exponential fog over the depth
+			if(density > 0) {
+
+				const float f = std::exp(-density * depth[i]);
+
+				r = r * f + fog[0] * (1 - f);
+				g = g * f + fog[1] * (1 - f);
+				b = b * f + fog[2] * (1 - f);
+			}
+
+			out[i] = pixel(
+				r < 0 ? 0 : (r > 255 ? 255 : r),
+				g < 0 ? 0 : (g > 255 ? 255 : g),
+				b < 0 ? 0 : (b > 255 ? 255 : b));
+		}
+	}
+}
+
+
+gbuffer_sample giulia::raymarch_gbuffer(
+	SDF f, vec3 camera, vec3 direction,
+	real min_distance, unsigned int max_steps) {
+
+	return raymarch_gbuffer(
+		[&f](vec3 p) { return f(p).distance; }, f,
+		camera, direction, min_distance, max_steps);
+}
+
+
+void giulia::compute_gbuffer(geometry_buffer& g, global_state& state, gbuffer_function sample) {
+
+	const unsigned int w = g.get_width();
+	const unsigned int h = g.get_height();
+
+#ifdef GIULIA_USE_OPENMP
+#pragma omp parallel for schedule(dynamic, 64)
+#endif
+
+	for (int i = 0; i < (int) g.get_size(); ++i) {
+
+		real_t x, y;
+		pixel_coords(i, w, h, x, y);
+		g.set_sample(i, sample(x, y, state));
+	}
+}
@@ -5,8 +5,17 @@
 #include "common.h"
 #include "image.h"
 #include "fractals.h"
+#include "formula.h"
 #include "raymarching.h"
+#include "sdf_scene.h"
 #include "geometry.h"
+#include "buddhabrot.h"
+#include "field.h"
+#include "palette.h"
+#include "render.h"
+#include "expmap.h"
+#include "nova.h"
+#include "atlas.h"
 
 #include <iostream>
 #include <cstdlib>
@@ -16,6 +25,12 @@ using namespace giulia;
 using namespace th;
 
 
+// Newton fractal of the third roots of unity, prepared once
+static const newton_fractal newton = newton_fractal(
+	{{1, 0}, {th::cos(TAU / 3), th::sin(TAU / 3)}, {th::cos(2 * TAU / 3), th::sin(2 * TAU / 3)}},
+	{pixel(200, 50, 50), pixel(50, 200, 50), pixel(50, 50, 200)});
+
+
 // Setup rendering variables
 void setup(global_state& state) {
 
@@ -24,6 +39,13 @@ void setup(global_state& state) {
 
 	state["translation.x"] = 0;
 	state["translation.y"] = 0;
+
+	// Choose the iteration limit of escape-time scenes from the zoom depth
+	// auto_max_iter(state, [](real_t x, real_t y, global_state& state) {
+	// 	return sample_mandelbrot(
+	// 		x * state["scale.x"] - state["translation.x"],
+	// 		y * state["scale.y"] - state["translation.y"], state["max_iter"]);
+	// });
 }
 
 
@@ -59,6 +81,39 @@ pixel draw(real_t x, real_t y, global_state& state) {
 
 	// return output;
 
+	// The same scene composed at compile time, so that
+	// its distance function is inlined in the marching loop
+	// static const auto scene = sdf::make_blend(
+	// 	sdf::make_blend(
+	// 		sdf::make_sphere({-1, 0, -6}, 1, pixel(0xFA0A0A)),
+	// 		sdf::make_sphere({1, 1, -7}, 1.5, pixel(0x0AFA0A)),
+	// 		0.7),
+	// 	sdf::make_sphere({-1, -1.5, -5.8}, 0.75, pixel(0x0A0AFA)),
+	// 	0.5);
+
+	// return raymarch_scene(scene, camera, direction);
+
+	// The same scene bounded over boxes, so that render_culled may
+	// fill the tiles whose frustum misses every sphere with the background
+	// [](real_t x_min, real_t y_min, real_t x_max, real_t y_max,
+	// 	global_state& state, pixel& fill) {
+
+	// 	const vec3 corners[4] = {
+	// 		{x_min, y_min, -1}, {x_max, y_min, -1},
+	// 		{x_min, y_max, -1}, {x_max, y_max, -1}};
+
+	// 	fill = pixel(0, 0, 0);
+	// 	return frustum_empty([](box3 pos) {
+	// 		return sdf::obj_blend(
+	// 			sdf::obj_blend(
+	// 				sdf::sphere(pos, {-1, 0, -6}, 1),
+	// 				sdf::sphere(pos, {1, 1, -7}, 1.5),
+	// 				0.7),
+	// 			sdf::sphere(pos, {-1, -1.5, -5.8}, 0.75),
+	// 			0.5);
+	// 	}, {0, 0, 0}, corners, 20);
+	// }
+
 	// z * z - sin(z) - 1
 	// z * z - sin(z) - 0.5
 
@@ -74,13 +129,72 @@ pixel draw(real_t x, real_t y, global_state& state) {
 	// 	return res;
 	// }, 2, 100);
 
-	return draw_newton_fractal(x, y, {{1, 0},
-		{th::cos(TAU / 3), th::sin(TAU / 3)}, {th::cos(2 * TAU / 3), th::sin(2 * TAU / 3)}},
-		{pixel(200, 50, 50), pixel(50, 200, 50), pixel(50, 50, 200)});
+	// Crisp Mandelbrot filaments from a single sample, antialiased
+	// over the pixel footprint by the exterior distance estimate
+	// return shade_distance(sample_mandelbrot(x, y, 1000),
+	// 	state["scale.x"] / state["width"], 1000, 40);
+
+	// Lyapunov fractal of the sequence AABAB over [2, 4] x [2, 4]
+	// static const lyapunov_fractal lyapunov = lyapunov_fractal("AABAB");
+	// return lyapunov(3 + norm_x * 2, 3 + norm_y * 2);
+
+	// Newton fractal of the same function, with exact derivatives
+	// static const palette roots = palette::giulia_present();
+	// return draw_newton_function(x, y, [](complex_dual z) {
+	// 	return cube(z) - square(sin(z));
+	// }, roots);
+
+	// The same fractal compiled from a formula at runtime
+	// static const formula f = formula("z^3 - sin(z)^2");
+	// return draw_formula(x, y, f, 2, 100);
+
+	return newton(x, y);
 }
 
 
 void postprocess(image& img, global_state& state) {
+
+	// Compute a field raising the iteration limit of the tiles which need it
+	// iteration_field adaptive = iteration_field(img.get_width(), img.get_height());
+	// compute_field_adaptive(adaptive, state, [](real_t x, real_t y, global_state& state) {
+	// 	return sample_mandelbrot(
+	// 		x * state["scale.x"] - state["translation.x"],
+	// 		y * state["scale.y"] - state["translation.y"], state["max_iter"]);
+	// });
+	// shade_field(adaptive, img, palette::giulia_present(), 20);
+
+	// Recolor a saved iteration field without recomputing it
+	// iteration_field f;
+	// if(!f.load("giulia.gfld"))
+	// 	shade_field(f, img, [](const field_sample& s, real_t x, real_t y) {
+	// 		return shade_giulia_present(s, x * 5, y * 5);
+	// 	});
+
+	// Recolor it through a precomputed gradient palette instead
+	// if(!f.load("giulia.gfld"))
+	// 	shade_field(f, img, palette::giulia_present(), 20);
+
+	// Contact sheet of 16 x 16 Julia sets, with its index in the Mandelbrot plane
+	// julia_atlas atlas = julia_atlas(16, img.get_width() / 16);
+	// image sheet = image(atlas.get_size(), atlas.get_size());
+	// atlas.render(sheet);
+	// sheet.save("atlas.bmp");
+	// atlas.draw_index(img);
+
+	// Nebulabrot with three escape time bands
+	// buddhabrot b = buddhabrot(img.get_width(), img.get_height());
+	// b.add_channel(20, 200, pixel(0, 0, 255));
+	// b.add_channel(200, 2000, pixel(0, 255, 0));
+	// b.add_channel(2000, 5000, pixel(255, 0, 0));
+	// b.render(10000000, true, state["seed"]);
+	// b.draw(img);
+
+	// Zoom video into the Seahorse valley, resampled from an exponential map
+	// exp_map zoom = exp_map(-0.743643887, 0.131825904, 4, 1E-6);
+	// zoom.render([](real_t x, real_t y) { return draw_mandelbrot(x, y, 2000); });
+	// zoom.render_frames(img.get_width(), img.get_height(), 3600, "zoom",
+	// 	[](real_t x, real_t y) { return draw_mandelbrot(x, y, 2000); });
+
 	// draw_sierpinski_triangle(img);
 	// negative(img);
 	// contrast(img, 0.9, 0);
@@ -141,31 +255,28 @@ int main(int argc, char const *argv[]) {
 	// Setup global state before rendering
 	setup(state);
 
-	std::cout << "Rendering image ..." << std::endl;
-
-#ifdef GIULIA_USE_OPENMP
-#pragma omp parallel for
-#endif
-
-	// Render the image
-	for (int i = 0; i < size; ++i) {
+	// Report the iteration limit chosen by the scene
+	if(state.count("max_iter"))
+		std::cout << "Iteration limit: " << state["max_iter"] << std::endl;
 
-		// if((i == (size * progress / 100))) {
-		// 	std::cout << "[" << progress << "%]" << std::endl;
-		// 	progress += 10;
-		// }
-
-		// state["iteration"] += 1;
-		
-		// Convert index to pixel location
-		real_t x = ((i % width) / (real_t) (width - 1)) - 0.5;
-		real_t y = ((((size - i) / (real_t) width) / (real_t) height) - 0.5) / aspect_ratio;
+	std::cout << "Rendering image ..." << std::endl;
 
-		// The origin corresponds to the center of the image
-
-		// Draw pixel
-		img[i] = supersampling(x, y, state, draw, state["supersampling"], 0.25 / state["width"]);
-	}
+	// Render the image, only drawing the fundamental domain of symmetric scenes
+	render(img, state, draw);
+
+	// Flat fill the tiles of a Mandelbrot scene which provably
+	// escape together with the same shade, by interval arithmetic
+	// render_culled(img, state, draw,
+	// 	[](real_t x_min, real_t y_min, real_t x_max, real_t y_max,
+	// 		global_state& state, pixel& fill) {
+	// 		return cull_mandelbrot(
+	// 			x_min * state["scale.x"] - state["translation.x"],
+	// 			y_min * state["scale.y"] - state["translation.y"],
+	// 			x_max * state["scale.x"] - state["translation.x"],
+	// 			y_max * state["scale.y"] - state["translation.y"],
+	// 			fill, 1000);
+	// 	});
+	// std::cout << "Culled " << state["culled"] << " tiles" << std::endl;
 
 	// std::cout << "[100%]" << std::endl;
 
@@ -173,6 +284,10 @@ int main(int argc, char const *argv[]) {
 	std::cout << "Post-processing ..." << std::endl;
 	postprocess(img, state);
 
+	if(state.count("max_iter.raised"))
+		std::cout << "Raised iteration limit of " << state["max_iter.raised"]
+			<< " tiles up to " << state["max_iter.peak"] << std::endl;
+
 	// Save the result to file
 	std::cout << "Saving image as " << filename << " ..." << std::endl;
 	int res = img.save(filename);
@@ -48,6 +48,16 @@ int giulia::image::save(const std::string& filename) {
 }
 
 
+void giulia::pixel_coords(unsigned int i, unsigned int w, unsigned int h, real_t& x, real_t& y) {
+
+	const unsigned int size = w * h;
+	const real_t aspect_ratio = w / (real_t) h;
+
+	x = ((i % w) / (real_t) (w - 1)) - 0.5;
+	y = ((((size - i) / (real_t) w) / (real_t) h) - 0.5) / aspect_ratio;
+}
+
+
 void apply(image& img, std::function<pixel(pixel)> f) {
 
 	for (size_t i = 0; i < img.get_size(); ++i)
@@ -0,0 +1,131 @@
+#include "normals.h"
+
+#define THEORETICA_LONG_DOUBLE_PREC
+#include "theoretica/core/real_analysis.h"
+
+#include <cmath>
+
+using namespace giulia;
+using namespace theoretica;
+namespace th = theoretica;
+
+
+namespace {
+
+	// Arccosine of a multidual number, with a null derivative at the ends
+	// of the domain, where it is not defined, instead of an error
+	inline dual3 dual_acos(dual3 x) {
+
+		const real c = clamp(x.Re(), -1, 1);
+		const real s = 1 - c * c;
+
+		return dual3(
+			th::acos(c),
+			s > 0 ? x.Dual() * (-1 / th::sqrt(s)) : vec3(0));
+	}
+
+
+	// Angle of the point (x, y) of the plane, as by atan2
+	inline dual3 dual_atan2(dual3 y, dual3 x) {
+
+		const real r2 = x.Re() * x.Re() + y.Re() * y.Re();
+
+		return dual3(
+			std::atan2((double) y.Re(), (double) x.Re()),
+			r2 > 0 ? (y.Dual() * x.Re() - x.Dual() * y.Re()) / r2 : vec3(0));
+	}
+
+
+	// Length of a point carrying derivatives
+	inline dual3 dual_length(const dual_vec3& p) {
+
+		const dual3 x = p.get(0);
+		const dual3 y = p.get(1);
+		const dual3 z = p.get(2);
+
+		return th::sqrt(x * x + y * y + z * z);
+	}
+
+}
+
+
+dual3 giulia::sdf::obj_union(dual3 a, dual3 b) {
+
+	return a.Re() < b.Re() ? a : b;
+}
+
+
+dual3 giulia::sdf::obj_blend(dual3 a, dual3 b, real k) {
+
+	dual3 h = (a - b) * (0.5 / k) + 0.5;
+
+	// The clamped ends are constant
+	if(h.Re() < 0)
+		h = dual3(0);
+	else if(h.Re() > 1)
+		h = dual3(1);
+
+	return a + (b - a) * h - h * (1 - h) * k;
+}
+
+
+dual3 giulia::sdf::obj_intersection(dual3 a, dual3 b) {
+
+	return a.Re() > b.Re() ? a : b;
+}
+
+
+dual3 giulia::sdf::obj_difference(dual3 a, dual3 b) {
+
+	return -a.Re() > b.Re() ? -a : b;
+}
+
+
+dual3 giulia::sdf::sphere(dual_vec3 pos, vec3 center, real radius) {
+
+	dual_vec3 p;
+
+	for (unsigned int k = 0; k < 3; ++k)
+		p[k] = pos.get(k) - center.get(k);
+
+	return dual_length(p) - radius;
+}
+
+
+dual3 giulia::sdf::mandelbulb_distance(dual_vec3 pos) {
+
+	dual_vec3 z = pos;
+	dual3 dr = 1;
+	dual3 r = 0;
+	int power = 8;
+
+	for (int i = 0; i < 10; i++) {
+
+		r = dual_length(z);
+
+		// Escape radius is 2
+		if (r.Re() > 2)
+			break;
+
+		// Polar coordinates
+		dual3 theta = dual_acos(z.get(2) / r);
+		dual3 phi = dual_atan2(z.get(1), z.get(0));
+
+		const dual3 r_pow_1 = th::pow(r, power - 1);
+		dr = r_pow_1 * dr * power + 1;
+
+		// Scale and rotate the point
+		const dual3 zr = r_pow_1 * r;
+		theta = theta * power;
+		phi = phi * power;
+
+		const dual3 sin_theta = th::sin(theta);
+
+		// Cartesian coordinates
+		z[0] = zr * sin_theta * th::cos(phi) + pos.get(0);
+		z[1] = zr * sin_theta * th::sin(phi) + pos.get(1);
+		z[2] = zr * th::cos(theta) + pos.get(2);
+	}
+
+	return th::ln(r) * r * 0.5 / dr;
+}
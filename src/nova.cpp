@@ -0,0 +1,74 @@
+#include "nova.h"
+
+#define THEORETICA_LONG_DOUBLE_PREC
+#include "theoretica/complex/complex_analysis.h"
+
+#include <cmath>
+
+using namespace giulia;
+using namespace theoretica;
+namespace th = theoretica;
+
+
+unsigned int giulia::nova_iterate(
+	real_t& z_a, real_t& z_b, real_t c_a, real_t c_b,
+	holomorphic_function f, real_t relaxation,
+	unsigned int max_iter, real_t epsilon) {
+
+	const complex c = complex(c_a, c_b);
+	const real_t sqr_epsilon = epsilon * epsilon;
+	complex z = complex(z_a, z_b);
+
+	for (unsigned int iter = 0; iter < max_iter; ++iter) {
+
+		// Value and exact derivative in a single evaluation
+		const complex_dual w = f(complex_dual(z, complex(1)));
+		const complex df = w.Dual();
+
+		if(df.square_modulus() == 0)
+			break;
+
+		const complex step = w.Re() / df * relaxation - c;
+		z -= step;
+
+		if(step.square_modulus() < sqr_epsilon) {
+			z_a = z.Re();
+			z_b = z.Im();
+			return iter;
+		}
+	}
+
+	z_a = z.Re();
+	z_b = z.Im();
+	return max_iter;
+}
+
+
+pixel giulia::draw_newton_function(
+	real_t x, real_t y, holomorphic_function f, const palette& p,
+	real_t relaxation, unsigned int max_iter, real_t epsilon) {
+
+	const unsigned int iter = nova_iterate(x, y, 0, 0, f, relaxation, max_iter, epsilon);
+
+	if(iter >= max_iter)
+		return pixel(0, 0, 0);
+
+	const pixel color = p(std::atan2((double) y, (double) x) / TAU);
+	const real_t intensity_factor = 1 - (iter / (real_t) max_iter);
+
+	return lerp(pixel(0, 0, 0), color, intensity_factor);
+}
+
+
+pixel giulia::draw_nova(
+	real_t x, real_t y, holomorphic_function f, const palette& p,
+	real_t relaxation, real_t z_a, real_t z_b,
+	unsigned int max_iter, real_t epsilon) {
+
+	const unsigned int iter = nova_iterate(z_a, z_b, x, y, f, relaxation, max_iter, epsilon);
+
+	if(iter >= max_iter)
+		return pixel(0, 0, 0);
+
+	return p(iter / (float) max_iter);
+}
@@ -0,0 +1,170 @@
+#include "orbit_trap.h"
+
+#define THEORETICA_LONG_DOUBLE_PREC
+#include "theoretica/core/real_analysis.h"
+
+using namespace giulia;
+using namespace theoretica;
+namespace th = theoretica;
+
+
+giulia::orbit_trap_engine::orbit_trap_engine(const std::vector<orbit_trap>& traps, real_t R)
+	: R(R) {
+
+	const unsigned int W = simd_real::width;
+	const orbit_trap_type types[] = {TRAP_POINT, TRAP_LINE, TRAP_CIRCLE, TRAP_CROSS};
+
+	n_traps = traps.size();
+	slot.resize(n_traps);
+
+	// Group traps of the same shape into packs, so that
+	// each pack is evaluated with a single branch free formula
+	for (unsigned int t = 0; t < 4; ++t) {
+
+		unsigned int lane = W;
+
+		for (unsigned int k = 0; k < n_traps; ++k) {
+
+			if(traps[k].type != types[t])
+				continue;
+
+			// Start a new pack, padded with far away traps which never win
+			if(lane == W) {
+				pack_type.push_back(types[t]);
+				px.resize(px.size() + W, 1E+30);
+				py.resize(py.size() + W, 1E+30);
+				dx.resize(dx.size() + W, 1);
+				dy.resize(dy.size() + W, 0);
+				r.resize(r.size() + W, 0);
+				lane = 0;
+			}
+
+			const unsigned int s = (pack_type.size() - 1) * W + lane;
+
+			px[s] = traps[k].x;
+			py[s] = traps[k].y;
+			dx[s] = th::cos(traps[k].angle);
+			dy[s] = th::sin(traps[k].angle);
+			r[s] = traps[k].radius;
+			slot[k] = s;
+			lane++;
+		}
+	}
+
+	n_packs = pack_type.size();
+}
+
+
+unsigned int giulia::orbit_trap_engine::iterate(
+	real_t& z_a, real_t& z_b, real_t c_a, real_t c_b,
+	real_t* dist, unsigned int max_iter, real_t init_dist) const {
+
+	const unsigned int W = simd_real::width;
+	const unsigned int P = block_packs;
+
+	// Every block iterates the same orbit from z_0
+	const real_t z0_a = z_a;
+	const real_t z0_b = z_b;
+
+	// Number of iterations
+	unsigned int i = 0;
+
+	// Blocks of packs, at least one so that traps are not needed to iterate
+	for (unsigned int first = 0; first == 0 || first < n_packs; first += P) {
+
+		const unsigned int count = (n_packs - first < P) ? n_packs - first : P;
+
+		// Trap parameters are kept in registers for the whole orbit
+		simd_real t_x[P], t_y[P], t_dx[P], t_dy[P], t_r[P];
+		simd_real min_dist[P];
+
+		for (unsigned int p = 0; p < count; ++p) {
+			t_x[p] = simd_real::load(&px[(first + p) * W]);
+			t_y[p] = simd_real::load(&py[(first + p) * W]);
+			t_dx[p] = simd_real::load(&dx[(first + p) * W]);
+			t_dy[p] = simd_real::load(&dy[(first + p) * W]);
+			t_r[p] = simd_real::load(&r[(first + p) * W]);
+			min_dist[p] = (double) (init_dist * init_dist);
+		}
+
+		real_t a = z0_a;
+		real_t b = z0_b;
+		i = 0;
+
+		while((a * a + b * b) < (R * R) && i <= max_iter) {
+
+			// z_i+1 = z_i ^ 2 + c
+			const real_t tmp = a * a - b * b + c_a;
+			b = 2 * a * b + c_b;
+			a = tmp;
+
+			const simd_real s_a = (double) a;
+			const simd_real s_b = (double) b;
+
+			// Squared distance to all traps of each pack at once
+			for (unsigned int p = 0; p < count; ++p) {
+
+				const simd_real w_a = s_a - t_x[p];
+				const simd_real w_b = s_b - t_y[p];
+				simd_real d2;
+
+				switch(pack_type[first + p]) {
+
+					case TRAP_POINT:
+						d2 = w_a * w_a + w_b * w_b;
+						break;
+
+					case TRAP_LINE: {
+						// Component across the line direction
+						const simd_real v = w_b * t_dx[p] - w_a * t_dy[p];
+						d2 = v * v;
+						break;
+					}
+
+					case TRAP_CIRCLE: {
+						// Circles need the distance itself, not its square
+						const simd_real e = simd::sqrt(w_a * w_a + w_b * w_b) - t_r[p];
+						d2 = e * e;
+						break;
+					}
+
+					case TRAP_CROSS: {
+						// Nearest of the two arms
+						const simd_real u = w_a * t_dx[p] + w_b * t_dy[p];
+						const simd_real v = w_b * t_dx[p] - w_a * t_dy[p];
+						d2 = simd::min(u * u, v * v);
+						break;
+					}
+				}
+
+				min_dist[p] = simd::min(min_dist[p], d2);
+			}
+
+			i++;
+		}
+
+		z_a = a;
+		z_b = b;
+
+		// A single square root per trap of the block
+		for (unsigned int k = 0; k < n_traps; ++k) {
+
+			const unsigned int p = slot[k] / W;
+
+			if(p >= first && p < first + count)
+				dist[k] = th::sqrt(min_dist[p - first][slot[k] % W]);
+		}
+	}
+
+	return i;
+}
+
+
+unsigned int giulia::orbit_trap_engine::size() const {
+	return n_traps;
+}
+
+
+real_t giulia::orbit_trap_engine::radius() const {
+	return R;
+}
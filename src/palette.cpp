@@ -0,0 +1,107 @@
+#include "palette.h"
+
+#define THEORETICA_LONG_DOUBLE_PREC
+#include "theoretica/core/real_analysis.h"
+
+using namespace giulia;
+using namespace theoretica;
+
+
+giulia::palette::palette(
+	const std::vector<palette_stop>& stops,
+	palette_mode mode, unsigned int size, unsigned int bands)
+	: size(size ? size : 1), mode(mode), bands(bands ? bands : 1) {
+
+	band_width = this->size / (float) this->bands;
+	inv_size = 1.0f / this->size;
+	lut.resize(this->size);
+
+	if(!stops.size())
+		return;
+
+	// Stops sorted by position
+	std::vector<palette_stop> s = stops;
+
+	for (size_t i = 1; i < s.size(); ++i)
+		for (size_t j = i; j > 0 && s[j].position < s[j - 1].position; --j)
+			std::swap(s[j], s[j - 1]);
+
+	size_t k = 0;
+
+	for (unsigned int i = 0; i < this->size; ++i) {
+
+		const real t = i / (real) (this->size - (mode == PALETTE_CLAMP ? 1 : 0));
+
+		while(k + 1 < s.size() && s[k + 1].position <= t)
+			k++;
+
+		if(t <= s[0].position || k + 1 == s.size()) {
+			lut[i] = (t <= s[0].position) ? s[0].color : s.back().color;
+			continue;
+		}
+
+		const real span = s[k + 1].position - s[k].position;
+		const real h = span > 0 ? (t - s[k].position) / span : 0;
+		const pixel a = s[k].color;
+		const pixel b = s[k + 1].color;
+
+		lut[i] = pixel(
+			a.r + ((int) b.r - a.r) * h,
+			a.g + ((int) b.g - a.g) * h,
+			a.b + ((int) b.b - a.b) * h);
+	}
+}
+
+
+pixel giulia::palette::get(unsigned int i) const {
+	return lut[i];
+}
+
+
+unsigned int giulia::palette::get_size() const {
+	return size;
+}
+
+
+palette giulia::palette::grayscale(palette_mode mode) {
+	return palette({{0, pixel(0, 0, 0)}, {1, pixel(255, 255, 255)}}, mode);
+}
+
+
+palette giulia::palette::giulia_present(palette_mode mode) {
+	return palette({
+		{0.0, pixel(0x9b5de5)},
+		{0.25, pixel(0xf15bb5)},
+		{0.5, pixel(0xfe0040)},
+		{0.75, pixel(0x0fbbb9)},
+		{1.0, pixel(0x9b5de5)}
+	}, mode);
+}
+
+
+pixel giulia::shade_palette(
+	const field_sample& s, const palette& p,
+	unsigned int max_iter, real_t scale, real_t offset) {
+
+	return p(s.iter / max_iter * scale + offset);
+}
+
+
+void giulia::shade_field(
+	const iteration_field& f, image& img, const palette& p, real_t scale, real_t offset) {
+
+	if(img.get_width() != f.get_width() || img.get_height() != f.get_height())
+		return;
+
+	const float* iter = f.get_iter();
+	const float k = scale / f.get_max_iter();
+	const float o = offset;
+	pixel* out = img.get_data();
+
+#ifdef GIULIA_USE_OPENMP
+#pragma omp parallel for
+#endif
+
+	for (int i = 0; i < (int) f.get_size(); ++i)
+		out[i] = p(iter[i] * k + o);
+}
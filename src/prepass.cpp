@@ -0,0 +1,196 @@
+#include "prepass.h"
+#include "sdf_scene.h"
+
+#define THEORETICA_LONG_DOUBLE_PREC
+#include "theoretica/core/real_analysis.h"
+
+#include <cmath>
+
+using namespace giulia;
+using namespace theoretica;
+namespace th = theoretica;
+
+
+giulia::depth_prepass::depth_prepass(
+	unsigned int width, unsigned int height,
+	unsigned int block, unsigned int min_block)
+	: width(width), height(height), block(block), min_block(min_block) {
+
+	if(!this->min_block)
+		this->min_block = 1;
+
+	if(this->block < this->min_block)
+		this->block = this->min_block;
+}
+
+
+void giulia::depth_prepass::block_bounds(
+	unsigned int size, unsigned int bx, unsigned int by,
+	real_t& x_min, real_t& y_min, real_t& x_max, real_t& y_max) const {
+
+	// Spacing of the pixels in normalized coordinates, as by pixel_coords
+	const real_t sx = 1 / (real_t) (width - 1);
+	const real_t sy = 1 / (real_t) width;
+	const real_t top = 0.5 * height / (real_t) width;
+
+	// Blocks extend half a pixel beyond their outer pixel centers
+	x_min = (bx * size - 0.5) * sx - 0.5;
+	x_max = ((bx + 1) * size - 0.5) * sx - 0.5;
+	y_max = top - (by * size - 0.5) * sy;
+	y_min = top - ((by + 1) * size - 0.5) * sy;
+}
+
+
+void giulia::depth_prepass::march(
+	distance_SDF d, vec3 camera, camera_function direction,
+	real min_distance, unsigned int max_steps) {
+
+	this->d = d;
+	this->camera = camera;
+	this->direction = direction;
+
+	std::vector<real> parent;
+	unsigned int parent_size = 0;
+	unsigned int parent_x = 0;
+	unsigned int parent_y = 0;
+
+	// From the coarsest level down to the finest one
+	for (unsigned int size = block; size >= min_block; size /= 2) {
+
+		const unsigned int nx = (width + size - 1) / size;
+		const unsigned int ny = (height + size - 1) / size;
+		std::vector<real> level(nx * ny, 0);
+
+#ifdef GIULIA_USE_OPENMP
+#pragma omp parallel for schedule(dynamic, 4)
+#endif
+		for (int b = 0; b < (int) (nx * ny); ++b) {
+
+			const unsigned int bx = b % nx;
+			const unsigned int by = b / nx;
+
+			real_t x_min, y_min, x_max, y_max;
+			block_bounds(size, bx, by, x_min, y_min, x_max, y_max);
+
+			// Axis of the cone through the center of the block, and half angle
+			// enclosing the rays through its corners
+			const vec3 axis = direction((x_min + x_max) / 2, (y_min + y_max) / 2);
+			real angle = 0;
+
+			for (unsigned int c = 0; c < 4; ++c) {
+
+				const vec3 corner = direction(
+					(c & 1) ? x_max : x_min,
+					(c & 2) ? y_max : y_min);
+
+				const real cos_angle = clamp(axis * corner, -1, 1);
+				angle = th::max(angle, (real) std::acos((double) cos_angle));
+			}
+
+			// Start from the depth of the parent blocks overlapping this one
+			real t = parent.size() ? inf() : 0;
+
+			if(parent.size()) {
+
+				const unsigned int px0 = (bx * size) / parent_size;
+				const unsigned int py0 = (by * size) / parent_size;
+				unsigned int px1 = ((bx + 1) * size - 1) / parent_size;
+				unsigned int py1 = ((by + 1) * size - 1) / parent_size;
+				px1 = px1 < parent_x ? px1 : parent_x - 1;
+				py1 = py1 < parent_y ? py1 : parent_y - 1;
+
+				for (unsigned int py = py0; py <= py1; ++py)
+					for (unsigned int px = px0; px <= px1; ++px)
+						t = th::min(t, parent[py * parent_x + px]);
+			}
+
+			for (unsigned int i = 0; i < max_steps; ++i) {
+
+				// The sphere of radius dist around the axis covers the cone
+				// up to the distance which leaves room for its growing width
+				const real dist = d(camera + axis * t);
+				const real free = dist - t * angle;
+
+				if(free < min_distance)
+					break;
+
+				t += free / (1 + angle);
+			}
+
+			level[b] = t;
+		}
+
+		parent = level;
+		parent_size = size;
+		parent_x = nx;
+		parent_y = ny;
+	}
+
+	block_size = parent_size;
+	blocks_x = parent_x;
+	blocks_y = parent_y;
+
+	// Lowest depth around each block, so that interpolating between
+	// the four blocks around any point never exceeds the depth of its block
+	depths.assign(parent.size(), 0);
+
+	for (unsigned int by = 0; by < blocks_y; ++by) {
+		for (unsigned int bx = 0; bx < blocks_x; ++bx) {
+
+			real t = parent[by * blocks_x + bx];
+
+			for (unsigned int y = (by ? by - 1 : 0); y <= by + 1 && y < blocks_y; ++y)
+				for (unsigned int x = (bx ? bx - 1 : 0); x <= bx + 1 && x < blocks_x; ++x)
+					t = th::min(t, parent[y * blocks_x + x]);
+
+			depths[by * blocks_x + bx] = t;
+		}
+	}
+}
+
+
+real giulia::depth_prepass::get_depth(real_t x, real_t y) const {
+
+	if(!depths.size())
+		return 0;
+
+	const real_t sx = 1 / (real_t) (width - 1);
+	const real_t sy = 1 / (real_t) width;
+	const real_t top = 0.5 * height / (real_t) width;
+
+	// Coordinates in blocks, with block centers at integer values
+	const real_t u = ((x + 0.5) / sx + 0.5) / block_size - 0.5;
+	const real_t v = ((top - y) / sy + 0.5) / block_size - 0.5;
+
+	if(u < -0.5 || v < -0.5 || u >= blocks_x - 0.5 || v >= blocks_y - 0.5)
+		return 0;
+
+	const real_t fu = std::floor((double) u);
+	const real_t fv = std::floor((double) v);
+	const real_t a = u - fu;
+	const real_t b = v - fv;
+
+	// Clamp the four blocks around the point to the grid
+	const long u0 = fu < 0 ? 0 : (long) fu;
+	const long v0 = fv < 0 ? 0 : (long) fv;
+	const long u1 = (long) fu + 1 < (long) blocks_x ? (long) fu + 1 : blocks_x - 1;
+	const long v1 = (long) fv + 1 < (long) blocks_y ? (long) fv + 1 : blocks_y - 1;
+
+	return (depths[v0 * blocks_x + u0] * (1 - a) + depths[v0 * blocks_x + u1] * a) * (1 - b)
+		+ (depths[v1 * blocks_x + u0] * (1 - a) + depths[v1 * blocks_x + u1] * a) * b;
+}
+
+
+pixel giulia::depth_prepass::raymarch(
+	SDF shade, real_t x, real_t y, pixel background,
+	real min_distance, unsigned int max_steps, bool lighting) const {
+
+	if(!d || !direction)
+		return background;
+
+	const vec3 dir = direction(x, y);
+
+	return raymarch_split(
+		d, shade, camera + dir * get_depth(x, y), dir, background,
+		min_distance, max_steps, lighting);
+}
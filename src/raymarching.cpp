@@ -1,81 +1,117 @@
 #include "raymarching.h"
+#include "sdf_scene.h"
 #include "theoretica/interpolation/spline_interp.h"
 
+#include <cmath>
+
 using namespace giulia;
 using namespace theoretica;
 namespace th = theoretica;
 
 
+namespace {
+
+	// Power (re + i im)^n of a complex number, by repeated squaring
+	inline void complex_power(real re, real im, unsigned int n, real& out_re, real& out_im) {
+
+		real res_re = 1;
+		real res_im = 0;
+
+		while(n) {
+
+			if(n & 1) {
+				const real t = res_re * re - res_im * im;
+				res_im = res_re * im + res_im * re;
+				res_re = t;
+			}
+
+			n >>= 1;
+
+			if(n) {
+				const real t = re * re - im * im;
+				im = 2 * re * im;
+				re = t;
+			}
+		}
+
+		out_re = res_re;
+		out_im = res_im;
+	}
+
+}
+
+
 pixel giulia::raymarch(
 	SDF f, vec3 camera, vec3 direction, pixel background,
 	real min_distance, unsigned int max_steps, bool lighting) {
 
+	return raymarch_split(
+		[&f](vec3 p) { return f(p).distance; }, f,
+		camera, direction, background, min_distance, max_steps, lighting);
+}
+
 
-	unsigned int i = 0;
-	real tot_distance = 0;
-	real minimum = 10000000;
-	de_object obj;
-	vec3 pos;
+pixel giulia::raymarch(
+	distance_SDF d, SDF shade, vec3 camera, vec3 direction, pixel background,
+	real min_distance, unsigned int max_steps, bool lighting) {
 
-	for (i = 0; i < max_steps; i++) {
+	return raymarch_split(d, shade, camera, direction, background, min_distance, max_steps, lighting);
+}
 
-		// Compute the current position
-		pos = camera + direction * tot_distance;
 
-		// Compute another step of distance estimation
-		obj = f(pos);
-		tot_distance += obj.distance;
-		obj.position = pos;
+pixel giulia::raymarch_relaxed(
+	SDF f, vec3 camera, vec3 direction, pixel background,
+	real relaxation, real pixel_radius, real far,
+	unsigned int max_steps, real grazing, bool lighting) {
 
-		if(obj.distance < minimum)
-			minimum = obj.distance;
+	return raymarch_relaxed(
+		[&f](vec3 p) { return f(p).distance; }, f,
+		camera, direction, background, relaxation,
+		pixel_radius, far, max_steps, grazing, lighting);
+}
 
-		// Stop when close enough
-		if (obj.distance < min_distance)
-			break;
-	}
 
-	// Set the distance of the object to the total computed distance
-	obj.distance = tot_distance;
+bool giulia::frustum_empty(
+	interval_SDF f, vec3 camera, const vec3 corners[4],
+	real far, unsigned int max_steps, real min_distance) {
 
-	if(i == max_steps) {
+	real s = 0;
+	real step = far / 64;
 
-		// Soft border
-		// real border_gradient = (1 - minimum * 10);
-		// obj.color = pixel(
-		// 	clamp(obj.color.r * border_gradient, 0, 255),
-		// 	clamp(obj.color.g * border_gradient, 0, 255),
-		// 	clamp(obj.color.b * border_gradient, 0, 255)
-		// );
+	for (unsigned int i = 0; i < max_steps && s < far; ++i) {
 
-		obj.color = background;
+		const real s_end = (s + step < far) ? s + step : far;
 
-	} else {
+		// Bounding box of the segment of the frustum between s and s_end,
+		// given by the corners of its two sections
+		box3 box;
+		for (unsigned int k = 0; k < 3; ++k) {
 
-		// Simple ambient occlusion
-		real coeff = square(1 - i / (real) max_steps);
-		
-		obj.color = pixel(
-			clamp(obj.color.r * coeff, 0, 255),
-			clamp(obj.color.g * coeff, 0, 255),
-			clamp(obj.color.b * coeff, 0, 255)
-		);
-
-		// Finite differences method for normal approximation
-		if(lighting) {
-
-			obj.normal = vec3({
-				f(pos + vec3({1, 0, 0})).distance - f(pos - vec3({1, 0, 0})).distance,
-				f(pos + vec3({0, 1, 0})).distance - f(pos - vec3({0, 1, 0})).distance,
-				f(pos + vec3({0, 0, 1})).distance - f(pos - vec3({0, 0, 1})).distance
-			}).normalized();
-
-		} else {
-			obj.normal = {0, 0, 0};
+			interval bound = interval(camera[k] + corners[0].get(k) * s);
+
+			for (unsigned int c = 0; c < 4; ++c) {
+				bound = hull(bound, interval(camera[k] + corners[c].get(k) * s));
+				bound = hull(bound, interval(camera[k] + corners[c].get(k) * s_end));
+			}
+
+			box[k] = bound;
+		}
+
+		// Advance over segments which no ray may hit, lengthening
+		// the next one, and retry with a shorter segment otherwise
+		if(f(box).lo > min_distance) {
+			s = s_end;
+			step *= 2;
+			continue;
 		}
+
+		step *= 0.5;
+
+		if(step < far * 1E-6)
+			return false;
 	}
 
-	return obj.color;
+	return s >= far;
 }
 
 
@@ -139,12 +175,17 @@ de_object giulia::sdf::sphere(vec3 pos, vec3 center, real radius, pixel color) {
 
 de_object giulia::sdf::mandelbulb(vec3 pos) {
 
+	return de_object(mandelbulb_distance(pos), pixel(255, 255, 255));
+}
+
+
+real giulia::sdf::mandelbulb_distance(vec3 pos, unsigned int power, unsigned int iterations) {
+
 	vec3 z = pos;
 	real dr = 1;
 	real r = 0;
-	int power = 8;
 
-	for (int i = 0; i < 10; i++) {
+	for (unsigned int i = 0; i < iterations; i++) {
 
 		r = z.length();
 
@@ -154,9 +195,9 @@ de_object giulia::sdf::mandelbulb(vec3 pos) {
 		
 		// Polar coordinates
 		real theta = th::acos(z[2] / r);
-		real phi = th::atan2(z[1], z[0]);
+		real phi = std::atan2((double) z[1], (double) z[0]);
 
-		const real r_pow_1 = th::pow(r, power - 1);
+		const real r_pow_1 = th::pow(r, (int) power - 1);
 		dr = r_pow_1 * power * dr + 1;
 		
 		// Scale and rotate the point
@@ -175,9 +216,115 @@ de_object giulia::sdf::mandelbulb(vec3 pos) {
 		z += pos;
 	}
 
-	de_object obj;
-	obj.distance = 0.5 * th::ln(r) * r / dr;
-	obj.color = pixel(255, 255, 255);
+	return 0.5 * th::ln(r) * r / dr;
+}
+
+
+real giulia::sdf::mandelbulb_polynomial(vec3 pos, unsigned int power, unsigned int iterations) {
+
+	real x = pos[0];
+	real y = pos[1];
+	real z = pos[2];
+	real dr = 1;
+	real r = 0;
+
+	for (unsigned int i = 0; i < iterations; i++) {
+
+		const real rho2 = x * x + y * y;
+		r = th::sqrt(rho2 + z * z);
+
+		// Escape radius is 2
+		if (r > 2)
+			break;
+
+		// Cosine and sine of the polar angles, from the coordinates
+		const real rho = th::sqrt(rho2);
+		const real cos_theta = r > 0 ? z / r : 1;
+		const real sin_theta = r > 0 ? rho / r : 0;
+		const real cos_phi = rho > 0 ? x / rho : 1;
+		const real sin_phi = rho > 0 ? y / rho : 0;
+
+		// Multiples of the angles, as powers of unit complex numbers
+		real cos_n_theta, sin_n_theta, cos_n_phi, sin_n_phi;
+		complex_power(cos_theta, sin_theta, power, cos_n_theta, sin_n_theta);
+		complex_power(cos_phi, sin_phi, power, cos_n_phi, sin_n_phi);
+
+		const real r_pow_1 = th::pow(r, (int) power - 1);
+		dr = r_pow_1 * power * dr + 1;
+
+		// Scale and rotate the point
+		const real zr = r_pow_1 * r;
+
+		x = zr * sin_n_theta * cos_n_phi + pos[0];
+		y = zr * sin_n_theta * sin_n_phi + pos[1];
+		z = zr * cos_n_theta + pos[2];
+	}
+
+	return 0.5 * th::ln(r) * r / dr;
+}
+
+
+real giulia::sdf::obj_union(real a, real b) {
+
+	return a < b ? a : b;
+}
+
+
+real giulia::sdf::obj_blend(real a, real b, real k) {
+
+	real h = clamp(0.5 + 0.5 * (a - b) / k, 0.0, 1.0);
+	return th::lerp(a, b, h) - k * h * (1.0 - h);
+}
+
+
+real giulia::sdf::obj_intersection(real a, real b) {
+
+	return a > b ? a : b;
+}
+
+
+real giulia::sdf::obj_difference(real a, real b) {
+
+	return -a > b ? -a : b;
+}
+
+
+real giulia::sdf::sphere(vec3 pos, vec3 center, real radius) {
+
+	return (pos - center).length() - radius;
+}
+
+
+interval giulia::sdf::obj_union(interval a, interval b) {
+
+	return min(a, b);
+}
+
+
+interval giulia::sdf::obj_blend(interval a, interval b, real k) {
+
+	// The blended distance grows with both distances
+	return interval(obj_blend(a.lo, b.lo, k), obj_blend(a.hi, b.hi, k));
+}
+
+
+interval giulia::sdf::obj_intersection(interval a, interval b) {
+
+	return max(a, b);
+}
+
+
+interval giulia::sdf::obj_difference(interval a, interval b) {
+
+	return max(-a, b);
+}
+
+
+interval giulia::sdf::sphere(box3 pos, vec3 center, real radius) {
+
+	box3 d;
+	for (unsigned int k = 0; k < 3; ++k)
+		d[k] = pos[k] - center[k];
 
-	return obj;
+	return length(d) - radius;
 }
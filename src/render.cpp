@@ -0,0 +1,312 @@
+#include "render.h"
+
+#define THEORETICA_LONG_DOUBLE_PREC
+#include "theoretica/core/real_analysis.h"
+
+#include <cmath>
+#include <vector>
+
+using namespace giulia;
+using namespace theoretica;
+namespace th = theoretica;
+
+
+namespace {
+
+
+	// Symmetry of a scene as a group of maps between pixel indices, about
+	// a center (ci, cj) lying on a pixel center, edge or corner
+	struct symmetry {
+
+		int mode;
+		unsigned int width;
+		unsigned int height;
+
+		// Twice the center, in pixel indices
+		long ci2;
+		long cj2;
+
+		// Whether rotations use quarter turns or only half turns
+		bool quarter;
+
+
+		// Number of maps of the group besides the identity
+		unsigned int size() const {
+
+			switch(mode) {
+				case SYMMETRY_MIRROR_X: return 1;
+				case SYMMETRY_MIRROR_Y: return 1;
+				case SYMMETRY_POINT: return 1;
+				case SYMMETRY_ROTATION: return quarter ? 3 : 1;
+				default: return 0;
+			}
+		}
+
+
+		// Apply the <k>-th map to the pixel (i, j), returning
+		// whether the image of the pixel is in the image
+		bool map(unsigned int k, long i, long j, long& mi, long& mj) const {
+
+			switch(mode) {
+
+				case SYMMETRY_MIRROR_X:
+					mi = i;
+					mj = cj2 - j;
+					break;
+
+				case SYMMETRY_MIRROR_Y:
+					mi = ci2 - i;
+					mj = j;
+					break;
+
+				case SYMMETRY_ROTATION:
+					if(quarter && k != 1) {
+
+						// Quarter turns, which need ci + cj to be whole
+						const long s = k == 0 ? 1 : -1;
+						mi = (ci2 + s * (2 * j - cj2)) / 2;
+						mj = (cj2 - s * (2 * i - ci2)) / 2;
+						break;
+					}
+
+				// Half turn
+				case SYMMETRY_POINT:
+					mi = ci2 - i;
+					mj = cj2 - j;
+					break;
+
+				default:
+					return false;
+			}
+
+			return mi >= 0 && mj >= 0 && mi < width && mj < height;
+		}
+
+
+		// The pixel drawn for pixel <p>, which is the first pixel of
+		// its orbit in the image, so that every orbit is drawn once
+		long source(long p) const {
+
+			const long i = p % width;
+			const long j = p / width;
+			long first = p;
+
+			for (unsigned int k = 0; k < size(); ++k) {
+
+				long mi, mj;
+				if(map(k, i, j, mi, mj) && mj * width + mi < first)
+					first = mj * width + mi;
+			}
+
+			return first;
+		}
+	};
+
+
+	// Center of the symmetry of a scene in pixel indices, in the grid of
+	// pixel_coords() without its shift along each row. The grid is moved by
+	// less than a pixel so that the center lies on a pixel center, edge or
+	// corner, as far as the symmetry needs to map pixels exactly onto pixels.
+	inline void symmetry_center(
+		unsigned int w, unsigned int h, global_state& state, real_t& ci, real_t& cj) {
+
+		ci = (state["symmetry.x"] + 0.5) * (w - 1);
+		cj = h * 0.5 - state["symmetry.y"] * (w - 1);
+
+		const real_t ci_half = std::floor((double) (2 * ci + 0.5)) / 2;
+		const real_t cj_half = std::floor((double) (2 * cj + 0.5)) / 2;
+		const unsigned int order = state["symmetry.order"] >= 2 ? state["symmetry.order"] : 2;
+
+		switch((int) state["symmetry"]) {
+
+			case SYMMETRY_MIRROR_X:
+				cj = cj_half;
+				break;
+
+			case SYMMETRY_MIRROR_Y:
+				ci = ci_half;
+				break;
+
+			case SYMMETRY_ROTATION:
+
+				if(order % 2)
+					break;
+
+				// Quarter turns need ci + cj to be whole, so cj
+				// moves to the nearest value of the same kind as ci
+				if(order % 4 == 0 && std::fmod((double) (ci_half + cj_half), 1.0) != 0) {
+					ci = ci_half;
+					cj = cj_half + (cj > cj_half ? 0.5 : -0.5);
+					break;
+				}
+
+			case SYMMETRY_POINT:
+				ci = ci_half;
+				cj = cj_half;
+				break;
+
+			default: break;
+		}
+	}
+
+}
+
+
+void giulia::symmetric_coords(
+	unsigned int i, unsigned int w, unsigned int h,
+	global_state& state, real_t& x, real_t& y) {
+
+	real_t ci, cj;
+	symmetry_center(w, h, state, ci, cj);
+
+	// Square pixels of the same width as those of pixel_coords()
+	const real_t step = 1 / (real_t) (w - 1);
+
+	x = state["symmetry.x"] + ((real_t) (i % w) - ci) * step;
+	y = state["symmetry.y"] - ((real_t) (i / w) - cj) * step;
+}
+
+
+void giulia::render(image& img, global_state& state, draw_function draw) {
+
+	const unsigned int width = img.get_width();
+	const unsigned int height = img.get_height();
+	const unsigned int size = width * height;
+	const unsigned int level = state["supersampling"] ? state["supersampling"] : 1;
+	const real_t stepsize = 0.25 / width;
+
+	symmetry sym;
+	sym.mode = state["symmetry"];
+	sym.width = width;
+	sym.height = height;
+
+	if(sym.mode == SYMMETRY_NONE) {
+
+#ifdef GIULIA_USE_OPENMP
+#pragma omp parallel for
+#endif
+		for (int i = 0; i < (int) size; ++i) {
+
+			// Convert index to pixel location
+			real_t x, y;
+			pixel_coords(i, width, height, x, y);
+
+			// Draw pixel
+			img[i] = supersampling(x, y, state, draw, level, stepsize);
+		}
+
+		return;
+	}
+
+	real_t ci, cj;
+	symmetry_center(width, height, state, ci, cj);
+	sym.ci2 = 2 * ci;
+	sym.cj2 = 2 * cj;
+
+	// Only the rotations of the pixel grid map pixels onto pixels
+	const unsigned int order = state["symmetry.order"] >= 2 ? state["symmetry.order"] : 2;
+	sym.quarter = (order % 4 == 0);
+
+	if(sym.mode == SYMMETRY_ROTATION && order % 2)
+		sym.mode = SYMMETRY_NONE;
+
+	// Draw the first pixel of each orbit, including the
+	// pixels whose images fall outside of the image
+#ifdef GIULIA_USE_OPENMP
+#pragma omp parallel for schedule(dynamic, 256)
+#endif
+	for (int i = 0; i < (int) size; ++i) {
+
+		if(sym.source(i) != i)
+			continue;
+
+		real_t x, y;
+		symmetric_coords(i, width, height, state, x, y);
+		img[i] = supersampling(x, y, state, draw, level, stepsize);
+	}
+
+	// Copy the rest of each orbit
+#ifdef GIULIA_USE_OPENMP
+#pragma omp parallel for
+#endif
+	for (int i = 0; i < (int) size; ++i) {
+
+		const long j = sym.source(i);
+
+		if(j != i)
+			img[i] = img[j];
+	}
+}
+
+
+void giulia::render_culled(
+	image& img, global_state& state, draw_function draw,
+	cull_function cull, unsigned int tile) {
+
+	const unsigned int width = img.get_width();
+	const unsigned int height = img.get_height();
+	const unsigned int level = state["supersampling"] ? state["supersampling"] : 1;
+	const real_t stepsize = 0.25 / width;
+
+	if(!tile)
+		tile = 16;
+
+	const unsigned int tiles_x = (width + tile - 1) / tile;
+	const unsigned int tiles_y = (height + tile - 1) / tile;
+
+	// Supersampling reaches a few steps away from the pixel centers
+	const real_t pad = level > 1 ? 6 * stepsize : 0;
+
+	unsigned int culled = 0;
+
+#ifdef GIULIA_USE_OPENMP
+#pragma omp parallel for schedule(dynamic, 1) reduction(+:culled)
+#endif
+	for (int t = 0; t < (int) (tiles_x * tiles_y); ++t) {
+
+		const unsigned int i0 = (t % tiles_x) * tile;
+		const unsigned int j0 = (t / tiles_x) * tile;
+		const unsigned int i1 = (i0 + tile < width) ? i0 + tile : width;
+		const unsigned int j1 = (j0 + tile < height) ? j0 + tile : height;
+
+		// Bounding box of the corner pixels, which holds the whole tile
+		// since the coordinates are monotonic along rows and columns
+		real_t x_min = inf(), y_min = inf();
+		real_t x_max = -inf(), y_max = -inf();
+
+		for (unsigned int c = 0; c < 4; ++c) {
+
+			real_t x, y;
+			const unsigned int i = (c & 1) ? i1 - 1 : i0;
+			const unsigned int j = (c & 2) ? j1 - 1 : j0;
+			pixel_coords(j * width + i, width, height, x, y);
+
+			x_min = x < x_min ? x : x_min;
+			y_min = y < y_min ? y : y_min;
+			x_max = x > x_max ? x : x_max;
+			y_max = y > y_max ? y : y_max;
+		}
+
+		pixel fill;
+		if(cull(x_min - pad, y_min - pad, x_max + pad, y_max + pad, state, fill)) {
+
+			for (unsigned int j = j0; j < j1; ++j)
+				for (unsigned int i = i0; i < i1; ++i)
+					img[j * width + i] = fill;
+
+			culled++;
+			continue;
+		}
+
+		for (unsigned int j = j0; j < j1; ++j) {
+			for (unsigned int i = i0; i < i1; ++i) {
+
+				real_t x, y;
+				pixel_coords(j * width + i, width, height, x, y);
+				img[j * width + i] = supersampling(x, y, state, draw, level, stepsize);
+			}
+		}
+	}
+
+	state["culled"] = culled;
+}
@@ -0,0 +1,275 @@
+#include "sdf_bvh.h"
+#include "sdf_scene.h"
+
+#define THEORETICA_LONG_DOUBLE_PREC
+#include "theoretica/core/real_analysis.h"
+
+#include <algorithm>
+
+using namespace giulia;
+using namespace theoretica;
+namespace th = theoretica;
+
+
+namespace {
+
+	// Depth of the traversal stack, enough for any balanced tree
+	const unsigned int max_depth = 64;
+
+
+	// Distance from <p> to the box [lo, hi], or zero inside of it
+	inline real box_distance(vec3 p, vec3 lo, vec3 hi) {
+
+		real sum = 0;
+
+		for (unsigned int k = 0; k < 3; ++k) {
+
+			real d = 0;
+
+			if(p[k] < lo[k])
+				d = lo[k] - p[k];
+			else if(p[k] > hi[k])
+				d = p[k] - hi[k];
+
+			sum += d * d;
+		}
+
+		return th::sqrt(sum);
+	}
+
+}
+
+
+unsigned int giulia::sdf_bvh::add(SDF f, vec3 center, real radius) {
+
+	primitive prim;
+	prim.f = f;
+	prim.center = center;
+	prim.radius = radius;
+
+	primitives.push_back(prim);
+	return primitives.size() - 1;
+}
+
+
+unsigned int giulia::sdf_bvh::add_sphere(vec3 center, real radius, pixel color) {
+
+	primitive prim;
+	prim.center = center;
+	prim.radius = radius;
+	prim.color = color;
+
+	primitives.push_back(prim);
+	return primitives.size() - 1;
+}
+
+
+void giulia::sdf_bvh::build(unsigned int leaf_size) {
+
+	order.resize(primitives.size());
+	for (unsigned int i = 0; i < order.size(); ++i)
+		order[i] = i;
+
+	nodes.clear();
+
+	if(!primitives.size())
+		return;
+
+	build_node(0, primitives.size(), leaf_size ? leaf_size : 1);
+}
+
+
+unsigned int giulia::sdf_bvh::build_node(
+	unsigned int first, unsigned int count, unsigned int leaf_size) {
+
+	const unsigned int index = nodes.size();
+	nodes.push_back(node());
+
+	// Bounds of the primitives and of their centers
+	vec3 lo = vec3(inf()), hi = vec3(-inf());
+	vec3 c_lo = vec3(inf()), c_hi = vec3(-inf());
+
+	for (unsigned int i = first; i < first + count; ++i) {
+
+		const primitive& prim = primitives[order[i]];
+
+		for (unsigned int k = 0; k < 3; ++k) {
+			lo[k] = th::min(lo[k], prim.center.get(k) - prim.radius);
+			hi[k] = th::max(hi[k], prim.center.get(k) + prim.radius);
+			c_lo[k] = th::min(c_lo[k], prim.center.get(k));
+			c_hi[k] = th::max(c_hi[k], prim.center.get(k));
+		}
+	}
+
+	nodes[index].lo = lo;
+	nodes[index].hi = hi;
+	nodes[index].first = first;
+	nodes[index].count = count;
+
+	if(count <= leaf_size)
+		return index;
+
+	// Split at the median center along the longest axis
+	unsigned int axis = 0;
+	for (unsigned int k = 1; k < 3; ++k)
+		if(c_hi[k] - c_lo[k] > c_hi[axis] - c_lo[axis])
+			axis = k;
+
+	const unsigned int half = count / 2;
+	std::nth_element(
+		order.begin() + first, order.begin() + first + half, order.begin() + first + count,
+		[this, axis](unsigned int a, unsigned int b) {
+			return primitives[a].center.get(axis) < primitives[b].center.get(axis);
+		});
+
+	const unsigned int left = build_node(first, half, leaf_size);
+	const unsigned int right = build_node(first + half, count - half, leaf_size);
+
+	nodes[index].left = left;
+	nodes[index].right = right;
+	nodes[index].count = 0;
+
+	return index;
+}
+
+
+real giulia::sdf_bvh::nearest(vec3 p, unsigned int& index) const {
+
+	real best = inf();
+	index = primitives.size();
+
+	if(!nodes.size())
+		return best;
+
+	unsigned int stack[max_depth];
+	unsigned int top = 0;
+	stack[top++] = 0;
+
+	while(top) {
+
+		const node& n = nodes[stack[--top]];
+
+		// Every primitive in the box is farther than its bounds
+		if(box_distance(p, n.lo, n.hi) >= best)
+			continue;
+
+		if(n.count) {
+
+			for (unsigned int i = n.first; i < n.first + n.count; ++i) {
+
+				const primitive& prim = primitives[order[i]];
+				const real bound = (p - prim.center).length() - prim.radius;
+
+				if(bound >= best)
+					continue;
+
+				// The bounding sphere of a sphere is the sphere itself
+				const real d = prim.f ? prim.f(p).distance : bound;
+
+				if(d < best) {
+					best = d;
+					index = order[i];
+				}
+			}
+
+			continue;
+		}
+
+		// Visit the nearer child first, pushing it last
+		const real d_left = box_distance(p, nodes[n.left].lo, nodes[n.left].hi);
+		const real d_right = box_distance(p, nodes[n.right].lo, nodes[n.right].hi);
+		const unsigned int near = d_left <= d_right ? n.left : n.right;
+		const unsigned int far = d_left <= d_right ? n.right : n.left;
+
+		if(top + 2 > max_depth)
+			break;
+
+		if(th::max(d_left, d_right) < best)
+			stack[top++] = far;
+
+		if(th::min(d_left, d_right) < best)
+			stack[top++] = near;
+	}
+
+	return best;
+}
+
+
+real giulia::sdf_bvh::distance(vec3 p) const {
+
+	unsigned int index;
+	return nearest(p, index);
+}
+
+
+de_object giulia::sdf_bvh::operator()(vec3 p) const {
+
+	unsigned int index;
+	const real d = nearest(p, index);
+
+	if(index >= primitives.size())
+		return de_object(d);
+
+	const primitive& prim = primitives[index];
+	return prim.f ? prim.f(p) : de_object(d, prim.color);
+}
+
+
+bool giulia::sdf_bvh::intersect(vec3 origin, vec3 direction, real& t_enter, real& t_exit) const {
+
+	if(!nodes.size())
+		return false;
+
+	t_enter = -inf();
+	t_exit = inf();
+
+	// Slabs of the root box along each axis
+	for (unsigned int k = 0; k < 3; ++k) {
+
+		const real lo = nodes[0].lo.get(k);
+		const real hi = nodes[0].hi.get(k);
+
+		if(direction[k] == 0) {
+
+			if(origin[k] < lo || origin[k] > hi)
+				return false;
+
+			continue;
+		}
+
+		real t0 = (lo - origin[k]) / direction[k];
+		real t1 = (hi - origin[k]) / direction[k];
+
+		if(t0 > t1)
+			std::swap(t0, t1);
+
+		t_enter = th::max(t_enter, t0);
+		t_exit = th::min(t_exit, t1);
+	}
+
+	return t_enter <= t_exit && t_exit >= 0;
+}
+
+
+pixel giulia::sdf_bvh::raymarch(
+	vec3 camera, vec3 direction, pixel background,
+	real min_distance, unsigned int max_steps, bool lighting) const {
+
+	real t_enter, t_exit;
+
+	if(!intersect(camera, direction, t_enter, t_exit))
+		return background;
+
+	// Skip the empty space in front of the bounds of the scene
+	const real start = th::max(t_enter, 0);
+
+	return raymarch_split(
+		[this](vec3 p) { return distance(p); }, *this,
+		camera + direction * start, direction, background,
+		min_distance, max_steps, lighting, t_exit - start);
+}
+
+
+unsigned int giulia::sdf_bvh::size() const {
+	return primitives.size();
+}
@@ -0,0 +1,350 @@
+#include "sdf_grid.h"
+#include "sdf_scene.h"
+
+#define THEORETICA_LONG_DOUBLE_PREC
+#include "theoretica/core/real_analysis.h"
+
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+using namespace giulia;
+using namespace theoretica;
+namespace th = theoretica;
+
+
+namespace {
+
+	// Header of grid files, followed by the distance at the center of each
+	// brick, the index of its samples and the dense samples, as 32-bit
+	// values in host byte order
+	struct grid_header {
+		char magic[4];
+		uint32_t version;
+		uint32_t brick;
+		uint32_t bricks_x;
+		uint32_t bricks_y;
+		uint32_t bricks_z;
+		uint32_t dense;
+		double lo[3];
+		double spacing;
+		double refine;
+	};
+
+	const char grid_magic[4] = {'G', 'S', 'D', 'F'};
+
+
+	// Index of the cell containing the coordinate <u>, in cell units,
+	// clamped to [0, n - 1]
+	inline unsigned int cell_index(double u, unsigned int n) {
+
+		if(u <= 0)
+			return 0;
+
+		const unsigned int i = (unsigned int) u;
+		return i < n ? i : n - 1;
+	}
+
+}
+
+
+giulia::sdf_grid::sdf_grid(
+	vec3 lo, vec3 hi, unsigned int resolution, unsigned int brick, real refine)
+	: lo(lo), brick(brick ? brick : 1) {
+
+	real extent = 0;
+	for (unsigned int k = 0; k < 3; ++k)
+		extent = th::max(extent, hi[k] - lo[k]);
+
+	spacing = extent / (resolution ? resolution : 1);
+	this->refine = refine > 0 ? refine : 2 * spacing;
+
+	// Bricks covering the box, rounding up
+	const real brick_size = spacing * this->brick;
+	bricks_x = (unsigned int) std::ceil((double) ((hi[0] - lo[0]) / brick_size));
+	bricks_y = (unsigned int) std::ceil((double) ((hi[1] - lo[1]) / brick_size));
+	bricks_z = (unsigned int) std::ceil((double) ((hi[2] - lo[2]) / brick_size));
+
+	bricks_x = bricks_x ? bricks_x : 1;
+	bricks_y = bricks_y ? bricks_y : 1;
+	bricks_z = bricks_z ? bricks_z : 1;
+}
+
+
+vec3 giulia::sdf_grid::sample_position(
+	unsigned int bx, unsigned int by, unsigned int bz,
+	unsigned int i, unsigned int j, unsigned int k) const {
+
+	return vec3({
+		lo.get(0) + (bx * brick + i) * spacing,
+		lo.get(1) + (by * brick + j) * spacing,
+		lo.get(2) + (bz * brick + k) * spacing
+	});
+}
+
+
+void giulia::sdf_grid::bake(distance_SDF d) {
+
+	exact = d;
+
+	const unsigned int n = get_bricks();
+	const unsigned int side = brick + 1;
+	const real half = brick * spacing * 0.5;
+
+	// Bricks whose center is farther than this from the surface
+	// do not reach within the refinement distance of it
+	const real threshold = half * th::sqrt(3) + refine + spacing;
+
+	centers.assign(n, 0);
+	index.assign(n, -1);
+
+#ifdef GIULIA_USE_OPENMP
+#pragma omp parallel for schedule(dynamic, 16)
+#endif
+	for (int b = 0; b < (int) n; ++b) {
+
+		const unsigned int bx = b % bricks_x;
+		const unsigned int by = (b / bricks_x) % bricks_y;
+		const unsigned int bz = b / (bricks_x * bricks_y);
+
+		const vec3 center = sample_position(bx, by, bz, 0, 0, 0) + vec3(half);
+		centers[b] = d(center);
+	}
+
+	// Assign storage to the bricks near the surface
+	int32_t dense = 0;
+
+	for (unsigned int b = 0; b < n; ++b)
+		if(th::abs(centers[b]) <= threshold)
+			index[b] = dense++;
+
+	samples.assign((size_t) dense * side * side * side, 0);
+
+#ifdef GIULIA_USE_OPENMP
+#pragma omp parallel for schedule(dynamic, 4)
+#endif
+	for (int b = 0; b < (int) n; ++b) {
+
+		if(index[b] < 0)
+			continue;
+
+		const unsigned int bx = b % bricks_x;
+		const unsigned int by = (b / bricks_x) % bricks_y;
+		const unsigned int bz = b / (bricks_x * bricks_y);
+		float* s = &samples[(size_t) index[b] * side * side * side];
+
+		for (unsigned int k = 0; k < side; ++k)
+			for (unsigned int j = 0; j < side; ++j)
+				for (unsigned int i = 0; i < side; ++i)
+					s[(k * side + j) * side + i] = d(sample_position(bx, by, bz, i, j, k));
+	}
+}
+
+
+void giulia::sdf_grid::set_exact(distance_SDF d) {
+	exact = d;
+}
+
+
+real giulia::sdf_grid::lookup(double x, double y, double z) const {
+
+	const unsigned int side = brick + 1;
+	const double h = spacing;
+
+	// Coordinates in cell units
+	const double u = (x - (double) lo.get(0)) / h;
+	const double v = (y - (double) lo.get(1)) / h;
+	const double w = (z - (double) lo.get(2)) / h;
+
+	const unsigned int bx = cell_index(u / brick, bricks_x);
+	const unsigned int by = cell_index(v / brick, bricks_y);
+	const unsigned int bz = cell_index(w / brick, bricks_z);
+	const unsigned int b = (bz * bricks_y + by) * bricks_x + bx;
+
+	// Coordinates within the brick
+	const double lu = u - bx * brick;
+	const double lv = v - by * brick;
+	const double lw = w - bz * brick;
+
+	// The distance at the center bounds the distance over a sparse brick
+	if(index[b] < 0) {
+
+		const double half = brick * 0.5;
+		const double r = std::sqrt(
+			(lu - half) * (lu - half) + (lv - half) * (lv - half)
+			+ (lw - half) * (lw - half)) * h;
+
+		return centers[b] > 0 ? centers[b] - r : centers[b] + r;
+	}
+
+	// Trilinear interpolation of the cell within the brick
+	const unsigned int i = cell_index(lu, brick);
+	const unsigned int j = cell_index(lv, brick);
+	const unsigned int k = cell_index(lw, brick);
+
+	const double a = lu - i;
+	const double c = lv - j;
+	const double e = lw - k;
+
+	const float* s0 = &samples[(size_t) index[b] * side * side * side + (k * side + j) * side + i];
+	const float* s1 = s0 + side * side;
+
+	const double d00 = s0[0] + (s0[1] - s0[0]) * a;
+	const double d10 = s0[side] + (s0[side + 1] - s0[side]) * a;
+	const double d01 = s1[0] + (s1[1] - s1[0]) * a;
+	const double d11 = s1[side] + (s1[side + 1] - s1[side]) * a;
+
+	const double d0 = d00 + (d10 - d00) * c;
+	const double d1 = d01 + (d11 - d01) * c;
+
+	// The samples are within sqrt(3) cells of the point, so that the
+	// interpolant may overstate the distance by as much, and is lowered
+	// by it to stay a bound
+	return d0 + (d1 - d0) * e - std::sqrt(3.0) * h;
+}
+
+
+real giulia::sdf_grid::distance(vec3 p) const {
+
+	if(!centers.size())
+		return exact ? exact(p) : inf();
+
+	// Lookups run in double precision, as the samples are floats
+	double x[3] = {(double) p[0], (double) p[1], (double) p[2]};
+	double outside = 0;
+
+	const unsigned int dims[3] = {bricks_x, bricks_y, bricks_z};
+	const double size = brick * (double) spacing;
+
+	// Clamp the point to the bounds of the grid
+	for (unsigned int k = 0; k < 3; ++k) {
+
+		const double lo_k = lo.get(k);
+		const double hi_k = lo_k + dims[k] * size;
+
+		if(x[k] < lo_k) {
+			outside += (lo_k - x[k]) * (lo_k - x[k]);
+			x[k] = lo_k;
+		} else if(x[k] > hi_k) {
+			outside += (x[k] - hi_k) * (x[k] - hi_k);
+			x[k] = hi_k;
+		}
+	}
+
+	// The surface lies within the bounds, and the distance from the grid,
+	// which is already a bound, bounds it from outside of them
+	if(outside > 0) {
+		outside = std::sqrt(outside);
+		return th::max(outside, lookup(x[0], x[1], x[2]) - outside);
+	}
+
+	const real dist = lookup(x[0], x[1], x[2]);
+
+	// Bounds below the refinement distance, including every bound
+	// which may be negative near the surface, are evaluated exactly
+	if(exact && dist < refine)
+		return exact(p);
+
+	return dist;
+}
+
+
+pixel giulia::sdf_grid::raymarch(
+	SDF shade, vec3 camera, vec3 direction, pixel background,
+	real min_distance, unsigned int max_steps, bool lighting) const {
+
+	return raymarch_split(
+		[this](vec3 p) { return distance(p); }, shade,
+		camera, direction, background, min_distance, max_steps, lighting);
+}
+
+
+unsigned int giulia::sdf_grid::get_bricks() const {
+	return bricks_x * bricks_y * bricks_z;
+}
+
+
+unsigned int giulia::sdf_grid::get_dense_bricks() const {
+
+	const unsigned int side = brick + 1;
+	return samples.size() / (side * side * side);
+}
+
+
+int giulia::sdf_grid::save(const std::string& filename) const {
+
+	std::ofstream file(filename, std::ios::binary);
+
+	if(!file)
+		return -1;
+
+	grid_header header;
+	std::memcpy(header.magic, grid_magic, 4);
+	header.version = 1;
+	header.brick = brick;
+	header.bricks_x = bricks_x;
+	header.bricks_y = bricks_y;
+	header.bricks_z = bricks_z;
+	header.dense = get_dense_bricks();
+	header.spacing = spacing;
+	header.refine = refine;
+
+	for (unsigned int k = 0; k < 3; ++k)
+		header.lo[k] = lo.get(k);
+
+	file.write((const char*) &header, sizeof(header));
+	file.write((const char*) centers.data(), centers.size() * sizeof(float));
+	file.write((const char*) index.data(), index.size() * sizeof(int32_t));
+	file.write((const char*) samples.data(), samples.size() * sizeof(float));
+
+	return file ? 0 : -1;
+}
+
+
+int giulia::sdf_grid::load(const std::string& filename) {
+
+	std::ifstream file(filename, std::ios::binary);
+
+	if(!file)
+		return -1;
+
+	grid_header header;
+	file.read((char*) &header, sizeof(header));
+
+	if(!file || std::memcmp(header.magic, grid_magic, 4)
+		|| header.version != 1 || !header.brick || !(header.spacing > 0))
+		return -1;
+
+	const size_t n = (size_t) header.bricks_x * header.bricks_y * header.bricks_z;
+	const size_t side = header.brick + 1;
+
+	std::vector<float> centers(n);
+	std::vector<int32_t> index(n);
+	std::vector<float> samples(header.dense * side * side * side);
+
+	file.read((char*) centers.data(), centers.size() * sizeof(float));
+	file.read((char*) index.data(), index.size() * sizeof(int32_t));
+	file.read((char*) samples.data(), samples.size() * sizeof(float));
+
+	if(!file)
+		return -1;
+
+	// Reject indices out of the dense samples
+	for (size_t b = 0; b < n; ++b)
+		if(index[b] >= (int32_t) header.dense)
+			return -1;
+
+	lo = vec3({header.lo[0], header.lo[1], header.lo[2]});
+	spacing = header.spacing;
+	refine = header.refine;
+	brick = header.brick;
+	bricks_x = header.bricks_x;
+	bricks_y = header.bricks_y;
+	bricks_z = header.bricks_z;
+
+	this->centers = centers;
+	this->index = index;
+	this->samples = samples;
+
+	return 0;
+}
@@ -0,0 +1,190 @@
+#include "sdf_packet.h"
+
+#define THEORETICA_LONG_DOUBLE_PREC
+#include "theoretica/core/real_analysis.h"
+
+#include <cmath>
+
+using namespace giulia;
+using namespace theoretica;
+namespace th = theoretica;
+
+
+// Whether the first <m> directions lie within an angle of each other,
+// as seen from the first one
+static bool coherent(const vec3* directions, unsigned int m, real angle) {
+
+	const real cos_angle = th::cos(angle);
+	const vec3 d0 = directions[0];
+	const real l0 = d0.length();
+
+	for (unsigned int l = 1; l < m; ++l) {
+
+		const vec3 d = directions[l];
+
+		if(d0 * d < cos_angle * l0 * d.length())
+			return false;
+	}
+
+	return true;
+}
+
+
+void giulia::raymarch_packet(
+	packet_SDF d, SDF shade,
+	vec3 camera, const vec3* directions, pixel* out, unsigned int n,
+	pixel background, real min_distance, unsigned int max_steps, real coherence) {
+
+	const unsigned int W = GIULIA_SIMD_WIDTH;
+	const simd_real3 origin = simd_real3(camera);
+	const simd_real eps = min_distance;
+
+	for (unsigned int base = 0; base < n; base += W) {
+
+		const unsigned int m = (n - base) < W ? (n - base) : W;
+
+		if(m < 2 || !coherent(directions + base, m, coherence)) {
+
+			for (unsigned int l = 0; l < m; ++l)
+				out[base + l] = raymarch(
+					shade, camera, directions[base + l], background, min_distance, max_steps);
+
+			continue;
+		}
+
+		// Unused lanes repeat the first ray and start stopped
+		simd_real3 dir;
+		simd_bool active;
+		for (unsigned int l = 0; l < W; ++l) {
+			dir.set(l, directions[base + (l < m ? l : 0)]);
+			active[l] = l < m;
+		}
+
+		simd_real t = 0;
+		simd_real3 hit = origin;
+		unsigned int steps[W];
+
+		for (unsigned int l = 0; l < W; ++l)
+			steps[l] = max_steps;
+
+		for (unsigned int i = 0; i < max_steps && active.any(); ++i) {
+
+			const simd_real3 pos = origin + dir * t;
+			const simd_real dist = d(pos);
+
+			// Advance the marching lanes and stop those close enough
+			t = simd::select(active, t + dist, t);
+			const simd_bool stop = active & (dist < eps);
+
+			hit.x = simd::select(stop, pos.x, hit.x);
+			hit.y = simd::select(stop, pos.y, hit.y);
+			hit.z = simd::select(stop, pos.z, hit.z);
+
+			for (unsigned int l = 0; l < W; ++l)
+				steps[l] = stop[l] ? i : steps[l];
+
+			active = active & !stop;
+		}
+
+		for (unsigned int l = 0; l < m; ++l) {
+
+			if(steps[l] == max_steps) {
+				out[base + l] = background;
+				continue;
+			}
+
+			const pixel color = shade(hit.get(l)).color;
+
+			// Simple ambient occlusion
+			const real coeff = square(1 - steps[l] / (real) max_steps);
+
+			out[base + l] = pixel(
+				clamp(color.r * coeff, 0, 255),
+				clamp(color.g * coeff, 0, 255),
+				clamp(color.b * coeff, 0, 255)
+			);
+		}
+	}
+}
+
+
+simd_real giulia::sdf::obj_union(const simd_real& a, const simd_real& b) {
+
+	return simd::min(a, b);
+}
+
+
+simd_real giulia::sdf::obj_blend(const simd_real& a, const simd_real& b, real k) {
+
+	const simd_real h = simd::min(simd::max(0.5 + (a - b) * (0.5 / (double) k), simd_real(0.0)), simd_real(1.0));
+	return a + (b - a) * h - h * (1.0 - h) * (double) k;
+}
+
+
+simd_real giulia::sdf::obj_intersection(const simd_real& a, const simd_real& b) {
+
+	return simd::max(a, b);
+}
+
+
+simd_real giulia::sdf::obj_difference(const simd_real& a, const simd_real& b) {
+
+	return simd::max(-a, b);
+}
+
+
+simd_real giulia::sdf::sphere(const simd_real3& pos, vec3 center, real radius) {
+
+	return (pos - simd_real3(center)).length() - (double) radius;
+}
+
+
+simd_real giulia::sdf::mandelbulb(const simd_real3& pos) {
+
+	const unsigned int W = GIULIA_SIMD_WIDTH;
+	const int power = 8;
+
+	simd_real3 z = pos;
+	simd_real dr = 1;
+	simd_real r = 0;
+	simd_bool active = simd_bool(true);
+
+	for (int i = 0; i < 10; i++) {
+
+		r = simd::select(active, z.length(), r);
+
+		// Escape radius is 2
+		active = active & !(r > simd_real(2));
+
+		if(!active.any())
+			break;
+
+		// Polar coordinates, advanced per lane
+		for (unsigned int l = 0; l < W; ++l) {
+
+			if(!active[l])
+				continue;
+
+			double theta = std::acos(z.z[l] / r[l]);
+			double phi = std::atan2(z.y[l], z.x[l]);
+
+			const double r2 = r[l] * r[l];
+			const double r_pow_1 = r2 * r2 * r2 * r[l];
+			dr[l] = r_pow_1 * power * dr[l] + 1;
+
+			// Scale and rotate the point
+			const double zr = r_pow_1 * r[l];
+			theta = theta * power;
+			phi = phi * power;
+
+			const double sin_theta = std::sin(theta);
+
+			// Cartesian coordinates
+			z.x[l] = zr * sin_theta * std::cos(phi) + pos.x[l];
+			z.y[l] = zr * sin_theta * std::sin(phi) + pos.y[l];
+			z.z[l] = zr * std::cos(theta) + pos.z[l];
+		}
+	}
+
+	return 0.5 * simd::log(r) * r / dr;
+}